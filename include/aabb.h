@@ -2,6 +2,8 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
+#include <vector>
+
 class AABB {
 public:
 	glm::vec2 min;
@@ -10,4 +12,26 @@ public:
 	AABB() {};
 	AABB(glm::vec2 min, glm::vec2 max);
 	AABB(float minX, float minY, float maxX, float maxY);
-};
\ No newline at end of file
+
+	bool Contains(const AABB& other) const;
+	float Perimeter() const;
+	AABB Expanded(float amount) const;
+
+	static AABB Combine(const AABB& a, const AABB& b);
+};
+
+// Bounds stored as separate min/max arrays so several boxes can be tested at once
+class AABBArray {
+public:
+	std::vector<float> minX;
+	std::vector<float> minY;
+	std::vector<float> maxX;
+	std::vector<float> maxY;
+
+	int Size() const { return minX.size(); }
+	void Resize(int size);
+	void Reserve(int count);
+	void Clear();
+	void Set(int index, const AABB& box);
+	AABB Get(int index) const { return AABB(minX[index], minY[index], maxX[index], maxY[index]); }
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+// Built with CHECK_ALLOCATIONS defined, operator new is replaced with one that counts calls.
+// Needs a current GL context since the engine creates its meshes.
+// Returns the heap allocations made by repeated Collide and FindContactPoints calls on
+// every pair of shapes, and by engine steps once the engine has warmed up.
+int CheckNarrowPhaseAllocations();
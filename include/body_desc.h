@@ -0,0 +1,74 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "mesh.h"
+
+// Why a body couldn't be created, one byte so a whole batch of results stays small
+enum class BodyError : unsigned char {
+	None,
+	SizeTooSmall,
+	SizeTooLarge,
+	DensityTooSmall,
+	DensityTooLarge,
+	InvalidShape,
+	CapacityReached     // the engine has a fixed capacity and it's full
+};
+
+// Everything needed to create a body, used to spawn many bodies at once with
+// Engine2D::SpawnBodies. Only the size fields of the desc's shape are used.
+struct BodyDesc {
+	static const int MAX_VERTICES = 8;
+
+	ShapeType shapeType;
+	glm::vec2 position;
+	float radius;
+	float width;
+	float height;
+	// ConvexPolygon only, relative to position in either winding. The body's position
+	// ends up at the polygon's centroid.
+	glm::vec2 vertices[MAX_VERTICES];
+	int vertexCount;
+	float density;
+	float restitution;
+	bool isStatic;
+
+	BodyDesc() : shapeType(ShapeType::Square), position(0.0f, 0.0f), radius(0.0f), width(0.0f), height(0.0f),
+		vertexCount(0), density(1.0f), restitution(0.5f), isStatic(false) {}
+
+	static BodyDesc Circle(float radius, glm::vec2 position, float density, bool isStatic, float restitution) {
+		BodyDesc desc;
+		desc.shapeType = ShapeType::Circle;
+		desc.position = position;
+		desc.radius = radius;
+		desc.density = density;
+		desc.isStatic = isStatic;
+		desc.restitution = restitution;
+		return desc;
+	}
+
+	static BodyDesc Square(float width, float height, glm::vec2 position, float density, bool isStatic, float restitution) {
+		BodyDesc desc;
+		desc.shapeType = ShapeType::Square;
+		desc.position = position;
+		desc.width = width;
+		desc.height = height;
+		desc.density = density;
+		desc.isStatic = isStatic;
+		desc.restitution = restitution;
+		return desc;
+	}
+
+	// More than MAX_VERTICES vertices is kept as an invalid shape for CheckBody to reject
+	static BodyDesc Polygon(const glm::vec2* vertices, int vertexCount, glm::vec2 position, float density, bool isStatic, float restitution) {
+		BodyDesc desc;
+		desc.shapeType = ShapeType::ConvexPolygon;
+		desc.position = position;
+		for (int i = 0; i < vertexCount && i < MAX_VERTICES; ++i) {
+			desc.vertices[i] = vertices[i];
+		}
+		desc.vertexCount = vertexCount;
+		desc.density = density;
+		desc.isStatic = isStatic;
+		desc.restitution = restitution;
+		return desc;
+	}
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+// Refers to a body added to an Engine2D. A handle keeps pointing at the same body while
+// other bodies are removed or storage is reordered. Once its body is removed the handle
+// is stale for good, a reused index always comes with a new generation.
+struct BodyHandle {
+	static const unsigned int INVALID_INDEX = 0xFFFFFFFFu;
+
+	unsigned int index;         // entry in the engine's handle table
+	unsigned int generation;
+
+	BodyHandle() : index(INVALID_INDEX), generation(0) {}
+	BodyHandle(unsigned int index, unsigned int generation) : index(index), generation(generation) {}
+
+	bool operator==(const BodyHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const BodyHandle& other) const { return !(*this == other); }
+};
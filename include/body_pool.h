@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Fixed size blocks for rigid bodies, carved out of chunks and recycled through a free
+// list so creating and destroying bodies doesn't go to the heap once the pool has grown
+// to the peak body count. Not thread safe, bodies are created and released on one thread.
+class BodyPool {
+public:
+	static const int CHUNK_SIZE = 64;   // blocks added at a time when the pool runs out
+
+	// Blocks hold an object of objectSize plus the shared_ptr control block around it
+	BodyPool(std::size_t objectSize);
+	~BodyPool();
+	BodyPool(const BodyPool&) = delete;
+	BodyPool& operator=(const BodyPool&) = delete;
+
+	// Requests bigger than a block fall back to the heap
+	void* Allocate(std::size_t size);
+	void Free(void* block, std::size_t size);
+	// Grows the pool to at least count blocks
+	void Reserve(int count);
+
+	int GetCapacity() const { return capacity; }
+	int GetUsedCount() const { return used; }
+
+private:
+	// Room left for the reference counts, deleter and allocator stored with the object
+	static const std::size_t CONTROL_BLOCK_SIZE = 64;
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	std::size_t blockSize;
+	std::vector<void*> chunks;
+	FreeBlock* freeList;
+	int capacity;
+	int used;
+
+	void AddChunk(int count);
+};
+
+// Allocator for std::allocate_shared that takes blocks from a BodyPool. It keeps the pool
+// alive, so bodies can outlive the engine that created them.
+template <typename T>
+class PoolAllocator {
+public:
+	typedef T value_type;
+
+	PoolAllocator(const std::shared_ptr<BodyPool>& pool) : pool(pool) {}
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool) {}
+
+	T* allocate(std::size_t n) { return static_cast<T*>(pool->Allocate(n * sizeof(T))); }
+	void deallocate(T* p, std::size_t n) { pool->Free(p, n * sizeof(T)); }
+
+	template <typename U>
+	bool operator==(const PoolAllocator<U>& other) const { return pool == other.pool; }
+	template <typename U>
+	bool operator!=(const PoolAllocator<U>& other) const { return pool != other.pool; }
+
+	std::shared_ptr<BodyPool> pool;
+};
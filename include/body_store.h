@@ -0,0 +1,75 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include "glm/glm.hpp"
+
+class RigidBody2D;
+
+// Moves values[newToOld[i]] to values[i] in place by following the cycles of the
+// permutation. visited is scratch, resized to values.size() without freeing its memory
+template <typename T>
+void PermuteInPlace(std::vector<T>& values, const std::vector<int>& newToOld, std::vector<unsigned char>& visited) {
+	visited.assign(values.size(), 0);
+	for (int start = 0; start < values.size(); ++start) {
+		if (visited[start]) {
+			continue;
+		}
+
+		T first = std::move(values[start]);
+		int i = start;
+		while (true) {
+			visited[i] = 1;
+			int from = newToOld[i];
+			if (from == start) {
+				values[i] = std::move(first);
+				break;
+			}
+			values[i] = std::move(values[from]);
+			i = from;
+		}
+	}
+}
+
+// State that changes every substep for all bodies in an engine, kept in separate dense
+// arrays indexed by slot so integration and the solver walk memory linearly.
+// While a body is in the store its getters and setters read and write these arrays.
+class BodyStore {
+public:
+	// Bits in dirty, set when the body moves so its cached Transform2D, AABB and world
+	// space vertices are rebuilt
+	static const unsigned char TRANSFORM_DIRTY = 1;
+	static const unsigned char AABB_DIRTY = 2;
+	static const unsigned char VERTICES_DIRTY = 4;
+	static const unsigned char MOVED = TRANSFORM_DIRTY | AABB_DIRTY | VERTICES_DIRTY;
+
+	std::vector<glm::vec2> position;
+	std::vector<glm::vec2> linearVelocity;
+	std::vector<float> angle;
+	std::vector<float> angularVelocity;
+	std::vector<float> invMass;         // zero for static bodies
+	std::vector<float> invInertia;
+	std::vector<unsigned char> dirty;
+	std::vector<RigidBody2D*> bodies;
+
+	BodyStore() {}
+	~BodyStore() { Clear(); }
+	// Bodies point back into the store, so it can't be copied
+	BodyStore(const BodyStore&) = delete;
+	BodyStore& operator=(const BodyStore&) = delete;
+
+	// Copies the body's state in and returns its slot
+	int Add(RigidBody2D* body);
+	// Copies the state back to the body, the body in the last slot moves into its slot
+	void Remove(int slot);
+	// Moves the body in slot newToOld[i] to slot i
+	void Permute(const std::vector<int>& newToOld);
+	void Clear();
+	void Reserve(int count);
+
+	int Size() const { return bodies.size(); }
+
+private:
+	void Detach(int slot);
+
+	std::vector<unsigned char> permuteVisited;
+};
@@ -2,39 +2,54 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
-#include "rigid_body_2D.h"
-
-#include <memory>
-
-
-class CollisionManifold {
-public:
-    const std::shared_ptr<RigidBody2D> bodyA;
-    const std::shared_ptr<RigidBody2D> bodyB;
-    const float depth;
-    const glm::vec2 normal;
-    const glm::vec2 contactOne;
-    const glm::vec2 contactTwo;
-    const int contactCount;
-
-    CollisionManifold(
-        const std::shared_ptr<RigidBody2D>& bodyA,
-        const std::shared_ptr<RigidBody2D>& bodyB,
-        float depth,
-        const glm::vec2 normal,
-        const glm::vec2 contactOne,
-        const glm::vec2 contactTwo,
-        int contactCount
-    )
-        : bodyA(bodyA), 
-        bodyB(bodyB),
-        depth(depth),
-        normal(normal),
-        contactOne(contactOne),
-        contactTwo(contactTwo),
-        contactCount(contactCount)
-    {
+
+
+// Which features of the two shapes produced a contact point, stays the same from step to
+// step while the shapes touch the same way so contacts can be matched up over time
+struct ContactFeature {
+    unsigned char referenceEdge;
+    unsigned char incidentEdge;
+    unsigned char point;        // 0 or 1 for an incident edge vertex, 2 or 3 if a side of the reference edge clipped it
+    unsigned char flip;         // 1 when the reference edge is on body B
+
+    ContactFeature() : referenceEdge(0), incidentEdge(0), point(0), flip(0) {}
+
+    unsigned int Key() const { return referenceEdge | (incidentEdge << 8) | (point << 16) | (flip << 24); }
+};
+
+// The support vertices GJK ended on for a pair of bodies. The next query for the pair
+// starts from them, so bodies that barely moved finish in an iteration or two.
+struct SimplexCache {
+    unsigned char count;        // 0 when nothing is cached
+    unsigned char indexA[3];
+    unsigned char indexB[3];
+
+    SimplexCache() : count(0) {}
+
+    // The same simplex seen with the bodies swapped
+    SimplexCache Flipped() const {
+        SimplexCache flipped;
+        flipped.count = count;
+        for (int i = 0; i < count; ++i) {
+            flipped.indexA[i] = indexB[i];
+            flipped.indexB[i] = indexA[i];
+        }
+        return flipped;
     }
 };
 
+// Contact between two bodies from the narrow phase. Bodies are referred to by their slot
+// in the engine, manifolds live in the engine's frame arena until the next Step.
+struct CollisionManifold {
+    int bodyA;
+    int bodyB;
+    float depth;
+    glm::vec2 normal;
+    glm::vec2 contactOne;
+    glm::vec2 contactTwo;
+    ContactFeature featureOne;
+    ContactFeature featureTwo;
+    int contactCount;
+};
+
 
@@ -6,32 +6,110 @@
 #include <memory>
 #include <cmath>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#define COLLISIONS_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLLISIONS_SSE2
+#endif
+
 #include "mesh.h"
 #include "rigid_body_2D.h"
+#include "span.h"
+#include "transform_2D.h"
+#include "collision_manifold.h"
 
 class Collisions {
 public:
+	// How far above the reference edge a clipped point can be and still count as a contact
+	static const float CONTACT_TOLERANCE;
+	// How much better B's edge has to face A before it becomes the reference edge
+	static const float REFERENCE_EDGE_BIAS;
+	// Closer than this the GJK cores count as overlapping and EPA takes over
+	static const float GJK_TOLERANCE;
+	// EPA stops once a new support point gets the polytope no further than this
+	static const float EPA_TOLERANCE;
+	static const int GJK_MAX_ITERATIONS = 20;
+	static const int EPA_MAX_VERTICES = 32;
+
+	// A convex shape as GJK sees it, the hull of vertices grown by radius. A circle is just
+	// its center with its radius.
+	struct ConvexProxy {
+		Span<glm::vec2> vertices;
+		float radius;
+
+		// Index of the vertex furthest along direction
+		int Support(glm::vec2 direction) const;
+	};
+
 	static bool IntersectCircles(glm::vec2 centerA, float radiusA, glm::vec2 centerB, float radiusB,
 	glm::vec2& normal, float& depth);
-	static bool IntersectPolygons(vector<glm::vec4> verticesA, vector<glm::vec4> verticesB, glm::vec2 polyCenterA, glm::vec2 polyCenterB, glm::vec2& normal, float& depth);
-	static bool IntersectCirclePolygon(glm::vec2 circleCenter, float circleRadius, vector<glm::vec4> vertices, glm::vec2 polyCenter, glm::vec2& normal, float& depth);
+	// Polygons are given as world space vertices and the outward unit normal of each edge i to i + 1
+	static bool IntersectPolygons(Span<glm::vec2> verticesA, Span<glm::vec2> normalsA, Span<glm::vec2> verticesB, Span<glm::vec2> normalsB,
+		glm::vec2 polyCenterA, glm::vec2 polyCenterB, glm::vec2& normal, float& depth);
+	// Fast path for two squares, takes each box's transform and half its width and height
+	static bool IntersectBoxes(const Transform2D& transformA, glm::vec2 halfExtentsA, const Transform2D& transformB, glm::vec2 halfExtentsB,
+		glm::vec2& normal, float& depth);
+	// The normal points from the circle to the polygon, contactPoint is the closest point on the polygon
+	static bool IntersectCirclePolygon(glm::vec2 circleCenter, float circleRadius, Span<glm::vec2> vertices, Span<glm::vec2> normals,
+		glm::vec2& normal, float& depth, glm::vec2& contactPoint);
 
-	static void FindContactPoints(std::shared_ptr<RigidBody2D> bodyA, std::shared_ptr<RigidBody2D> bodyB, glm::vec2& contactOne, glm::vec2& contactTwo, int& contactCount);
+	// Fills in the contact points and features Collide left out, contact's normal must already be set
+	static void FindContactPoints(RigidBody2D& bodyA, RigidBody2D& bodyB, CollisionManifold& contact);
 	static void FindContactPoint(glm::vec2 centerA, float radiusA, glm::vec2 centerB, glm::vec2& contactPoint);
-	static void FindContactPoint(glm::vec2 circleCenter, float circleRadius, glm::vec2 polygonCenter, vector<glm::vec4> polygonVertices, glm::vec2& collisionPoint);
-	static void FindContactPoint(vector<glm::vec4> verticesA, vector<glm::vec4> verticesB, glm::vec2& contact1, glm::vec2& contact2, int& contactCount);
+	// Up to two contacts from clipping the incident edge against the reference edge, normal points from A to B
+	static void ClipPolygons(Span<glm::vec2> verticesA, Span<glm::vec2> normalsA, Span<glm::vec2> verticesB, Span<glm::vec2> normalsB,
+		CollisionManifold& contact);
 
 	static void PointSegmentDistance(glm::vec2 p, glm::vec2 a, glm::vec2 b, float& distanceSquared, glm::vec2& contact);
 
 
-	static bool Collide(std::shared_ptr<RigidBody2D> bodyA, std::shared_ptr<RigidBody2D> bodyB, glm::vec2& normal, float& depth);
+	// Sets the normal and depth of contact, and its contact point too when the shapes have a circle
+	static bool Collide(RigidBody2D& bodyA, RigidBody2D& bodyB, CollisionManifold& contact);
+	// Same as Collide but every shape pair goes through IntersectConvex. cache is the pair's
+	// simplex from the last query, in bodyA, bodyB order, and is updated.
+	static bool CollideConvex(RigidBody2D& bodyA, RigidBody2D& bodyB, CollisionManifold& contact, SimplexCache& cache);
+	// GJK distance between the cores of any two convex shapes, then EPA for the depth when the
+	// cores overlap. The normal points from A to B, contactPoint is on A's surface.
+	static bool IntersectConvex(const ConvexProxy& proxyA, const ConvexProxy& proxyB, SimplexCache& cache,
+		glm::vec2& normal, float& depth, glm::vec2& contactPoint);
 
+	// Returns true when the boxes are separated
 	static bool IntersectAABBs(AABB a, AABB b);
+	static bool OverlapAABBs(const AABB& a, const AABB& b);
+	// Tests box against boxes [begin, end) eight or four at a time, writes the indices that overlap
+	// to hits and returns how many there were. hits needs room for end - begin entries.
+	static int OverlapAABBBatch(const AABB& box, const AABBArray& boxes, int begin, int end, int* hits);
 
 private:
+	struct ClipVertex {
+		glm::vec2 point;
+		ContactFeature feature;
+	};
+
+	// A point of the Minkowski difference B - A and the support points it came from
+	struct SimplexVertex {
+		glm::vec2 pointA;
+		glm::vec2 pointB;
+		glm::vec2 point;
+		float weight;       // barycentric, for the closest point
+		int indexA;
+		int indexB;
+	};
+
+	static ConvexProxy MakeProxy(RigidBody2D& body);
+	static SimplexVertex MakeSimplexVertex(const ConvexProxy& proxyA, const ConvexProxy& proxyB, int indexA, int indexB);
+	// Reduces the simplex to the smallest one holding the point closest to the origin, returns its size
+	static int SolveSimplex(SimplexVertex simplex[3], int count);
+	// Grows the simplex GJK ended on until it finds the edge of B - A closest to the origin
+	static void ExpandPolytope(const ConvexProxy& proxyA, const ConvexProxy& proxyB, const SimplexVertex* simplex, int count,
+		glm::vec2& normal, float& depth, glm::vec2& pointA);
 
-	static void ProjectVertices(vector<glm::vec4> vertices, glm::vec2 axis, float& min, float& max);
-	static void ProjectCircle(glm::vec2 center, float radius, glm::vec2 axis, float& min, float& max);
+	static int FindMostAlignedEdge(Span<glm::vec2> normals, glm::vec2 direction);
+	static int ClipSegment(const ClipVertex in[2], ClipVertex out[2], glm::vec2 normal, float offset, unsigned char sidePoint);
 
-	static int FindClosestPointOnPolygon(glm::vec2 circleCenter, vector<glm::vec4> vertices);
+	static void ProjectVertices(Span<glm::vec2> vertices, glm::vec2 axis, float& min, float& max);
+	static bool IntersectCircleVertex(glm::vec2 circleCenter, float circleRadius, glm::vec2 vertex, glm::vec2& normal, float& depth, glm::vec2& contactPoint);
 };
@@ -0,0 +1,17 @@
+#pragma once
+
+// Indices of two bodies whose AABBs overlap, item1 is always the lower index
+struct ContactPair {
+	int item1;
+	int item2;
+	int cacheIndex;     // entry in the engine's PairCache, set after the broad phase
+
+	ContactPair(int a, int b) : item1(a), item2(b), cacheIndex(-1) {}
+
+	bool operator<(const ContactPair& other) const {
+		if (item1 != other.item1) {
+			return item1 < other.item1;
+		}
+		return item2 < other.item2;
+	}
+};
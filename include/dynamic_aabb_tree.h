@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+
+#include "aabb.h"
+
+// Bounding volume tree where each leaf holds an enlarged ("fat") AABB for one body.
+// A leaf is only reinserted when its body moves outside the fat box, and the tree is
+// kept balanced with rotations so queries stay O(log n) with widely varying body sizes.
+class DynamicAABBTree {
+public:
+	static const int NULL_NODE = -1;
+	// Rotations keep the height near 1.44 log2(n), far below this for any body count
+	static const int QUERY_STACK_SIZE = 256;
+
+	DynamicAABBTree(float margin = 4.0f);
+
+	// Returns the proxy id for the new leaf
+	int CreateProxy(const AABB& box, int userData);
+	void DestroyProxy(int proxyId);
+	// Returns true if the body left its fat AABB and the leaf was reinserted
+	bool MoveProxy(int proxyId, const AABB& box);
+	void Clear();
+	// Room for count proxies, a tree of n leaves never has more than 2n - 1 nodes
+	void Reserve(int count) { nodes.reserve(2 * count); }
+
+	int GetUserData(int proxyId) const { return nodes[proxyId].userData; }
+	void SetUserData(int proxyId, int userData) { nodes[proxyId].userData = userData; }
+	const AABB& GetFatAABB(int proxyId) const { return nodes[proxyId].box; }
+	int GetHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+	// Calls callback(proxyId) for every leaf whose fat AABB overlaps box, stops early if it returns false.
+	// Safe to call from several threads at once as long as nothing modifies the tree.
+	template <typename T>
+	void Query(const AABB& box, T& callback) const;
+
+private:
+	struct TreeNode {
+		AABB box;
+		int userData;
+		int parent;     // next free node while the node is in the free list
+		int child1;
+		int child2;
+		int height;     // leaves are 0, free nodes are -1
+
+		bool IsLeaf() const { return child1 == NULL_NODE; }
+	};
+
+	std::vector<TreeNode> nodes;
+	int root;
+	int freeList;
+	float margin;
+
+	int AllocateNode();
+	void FreeNode(int nodeId);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	int Balance(int nodeId);
+};
+
+template <typename T>
+void DynamicAABBTree::Query(const AABB& box, T& callback) const {
+	if (root == NULL_NODE) {
+		return;
+	}
+
+	int stack[QUERY_STACK_SIZE];
+	int stackCount = 0;
+	stack[stackCount++] = root;
+
+	while (stackCount > 0) {
+		int nodeId = stack[--stackCount];
+
+		const TreeNode& node = nodes[nodeId];
+		if (node.box.max.x <= box.min.x || box.max.x <= node.box.min.x ||
+			node.box.max.y <= box.min.y || box.max.y <= node.box.min.y) {
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			if (!callback(nodeId)) {
+				return;
+			}
+		}
+		else {
+			stack[stackCount++] = node.child1;
+			stack[stackCount++] = node.child2;
+		}
+	}
+}
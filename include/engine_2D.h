@@ -4,9 +4,23 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "rigid_body_2D.h"
+#include "body_store.h"
+#include "body_handle.h"
+#include "body_pool.h"
+#include "frame_arena.h"
+#include "engine_config.h"
+#include "pair_buffer.h"
 #include "collisions.h"
 #include "shader.h"
 #include "collision_manifold.h"
+#include "contact_pair.h"
+#include "sweep_and_prune.h"
+#include "dynamic_aabb_tree.h"
+#include "spatial_hash_grid.h"
+#include "hierarchical_grid.h"
+#include "static_body_tree.h"
+#include "pair_cache.h"
+#include "thread_pool.h"
 
 #include <unordered_map>
 
@@ -15,11 +29,17 @@
 class Engine2D {
 public:
 
-	struct ContactPair {
-		int item1;
-		int item2;
+	enum class BroadPhaseType {
+		BruteForce,
+		SweepAndPrune,
+		AABBTree,
+		SpatialHash,
+		HierarchicalGrid
+	};
 
-		ContactPair(int a, int b) : item1(a), item2(b) {}
+	enum class NarrowPhaseType {
+		SAT,    // a test for each pair of shape types
+		GJK     // one test for every convex shape, warm started from the pair cache
 	};
 
 	static const float MIN_BODY_SIZE;
@@ -28,18 +48,64 @@ public:
 	static const float MIN_DENSITY;
 	static const float MAX_DENSITY;
 
-	Engine2D();
-
-	void AddBody(std::shared_ptr<RigidBody2D> body);
-	void RemoveBody(int index);
+	// Extra room around the swept bounds used when the broad phase runs once per step
+	static const float SWEPT_AABB_MARGIN;
+
+	Engine2D(const EngineConfig& config = EngineConfig());
+	const EngineConfig& GetConfig() const { return config; }
+	// Only counts anything when the config has fixedCapacity set
+	const CapacityOverflow& GetCapacityOverflow() const { return overflow; }
+	void ResetCapacityOverflow() { overflow = CapacityOverflow(); }
+
+	// Same as the RigidBody2D factories, but the body comes from the engine's pool and
+	// uses the engine's meshes
+	bool CreateCircleBody(float radius, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage);
+	bool CreateSquareBody(float width, float height, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage);
+	// Polygons with the same vertices share a mesh, see getPolygonMesh
+	bool CreatePolygonBody(const glm::vec2* vertices, int vertexCount, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage);
+	// Makes room for count bodies up front so adding and creating them doesn't allocate
+	void ReserveBodies(int count);
+	// Creates and adds a batch of bodies, making room for all of them at once. handles[i] is
+	// the new body or an invalid handle when desc i was rejected, errors[i] says why if
+	// errors isn't null. Returns the number of bodies added.
+	int SpawnBodies(Span<BodyDesc> descs, BodyHandle* handles, BodyError* errors = nullptr);
+	int SpawnBodies(const std::vector<BodyDesc>& descs, std::vector<BodyHandle>& handles, std::vector<BodyError>& errors);
+
+	// Returns an invalid handle if the engine has a fixed capacity and it's full
+	BodyHandle AddBody(std::shared_ptr<RigidBody2D> body);
+	// Returns false if the handle is stale
+	bool RemoveBody(BodyHandle handle);
+	// Removes a batch of bodies in time linear in the batch size, stale handles are skipped.
+	// Returns the number of bodies removed.
+	int RemoveBodies(const BodyHandle* handles, int count);
+	int RemoveBodies(const std::vector<BodyHandle>& handles) { return RemoveBodies(handles.data(), handles.size()); }
+	bool IsValid(BodyHandle handle) const;
+	bool GetBody(BodyHandle handle, std::shared_ptr<RigidBody2D>& body);
+
+	// Bodies are indexed from 0 to GetBodyCount() - 1 for iteration. Removing or reordering
+	// bodies changes the indices, use handles to keep track of a body.
 	bool GetBody(int index, std::shared_ptr<RigidBody2D>& body);
+	BodyHandle GetBodyHandle(int index);
 	int GetBodyCount() { return bodyList.size(); }
 
+	// Sorts body storage along a Morton curve, handles stay valid
+	void ReorderBodies();
+	// Reorders bodies every interval steps, 0 turns it off
+	void SetReorderInterval(int interval) { reorderInterval = interval; }
+
 	void Step(float time, int iterations);
 
-	void ResolveCollisionsBasic(CollisionManifold contact);
-	void ResolveCollisionsWithRotation(CollisionManifold contact);
-	void ResolveCollisionsWithRotationAndFriction(CollisionManifold contact);
+	// Bodies whose AABB is completely outside bounds are found while the broad phase
+	// updates and removed together at the end of the Step
+	void SetKillBounds(const AABB& bounds);
+	void ClearKillBounds() { killBoundsEnabled = false; }
+	// Handles of the bodies the kill bounds removed during the last Step, all stale by now
+	const std::vector<BodyHandle>& GetKilledBodies() const { return killedBodies; }
+
+	// Manifolds refer to bodies by their index in this engine
+	void ResolveCollisionsBasic(const CollisionManifold& contact);
+	void ResolveCollisionsWithRotation(const CollisionManifold& contact);
+	void ResolveCollisionsWithRotationAndFriction(const CollisionManifold& contact);
 
 
 	void Draw(Shader& shader, glm::mat4 trans);
@@ -49,6 +115,23 @@ public:
 
 	void StepBodies(float time, int iterations);
 
+	void SetBroadPhaseType(BroadPhaseType type);
+	BroadPhaseType GetBroadPhaseType() { return broadPhaseType; }
+	void SetSpatialHashCellSize(float size) { spatialHash.SetCellSize(size); }
+	void SetHierarchicalGridBaseCellSize(float size) { hierarchicalGrid.SetBaseCellSize(size); }
+	// Static bodies are assumed not to move, call this after moving or rotating one
+	void RefreshStaticBodies() { staticTreeDirty = true; }
+	// When enabled the pair search runs once per Step instead of once per substep
+	void SetBroadPhaseOncePerStep(bool enabled) { broadPhaseOncePerStep = enabled; }
+	void SetNarrowPhaseType(NarrowPhaseType type) { narrowPhaseType = type; }
+	NarrowPhaseType GetNarrowPhaseType() { return narrowPhaseType; }
+
+	// Threads used by the pair search besides the calling thread, the default is none
+	void SetWorkerThreadCount(int count) { threadPool.SetThreadCount(count); }
+
+	// Overlapping pairs from the last broad phase pass with their begin/persist/end state
+	const PairCache& GetPairCache() { return pairCache; }
+
 
 
 
@@ -57,13 +140,93 @@ public:
 private:
 	std::unordered_map<ShapeType, std::shared_ptr<Mesh>> meshes;
 	void createMeshes();
+	// Each distinct polygon gets a mesh that's kept for later bodies of the same shape. Once no
+	// body uses a mesh its entry is reused for the next new shape, so waves of the same debris
+	// don't create meshes and random shapes don't pile up.
+	struct PolygonMesh {
+		int vertexCount;
+		glm::vec2 vertices[RigidBody2D::MAX_POLYGON_VERTICES];
+		std::shared_ptr<Mesh> mesh;
+	};
+	std::vector<PolygonMesh> polygonMeshes;
+	std::shared_ptr<Mesh> getPolygonMesh(const RigidBody2D& body);
+
+	std::shared_ptr<BodyPool> bodyPool;
 
 	void BroadPhase();
+	void UpdateBodyBounds();
+	void UpdateSweptBounds(float time);
+	bool BodiesInsideBounds();
+	void FindPairs();
+	void UpdatePairCache();
+	void BroadPhaseBruteForce(int begin, int end, PairBuffer& pairs);
+	void BroadPhaseTree(int begin, int end, PairBuffer& pairs);
+	void FindPairsInRange(int begin, int end, PairBuffer& pairs);
+	void FindStaticPairsInRange(int begin, int end, PairBuffer& pairs);
 	void NarrowPhase();
 
-
+	void AddToBroadPhase(int index);
+	void ReserveBroadPhase(int count);
+	void CheckKillBounds(int index);
+	void RemoveKilledBodies();
+	bool IsFull() const;
+	void RemapBroadPhase(const std::vector<int>& oldToNew);
+	void BuildStaticTree();
+
+	BroadPhaseType broadPhaseType;
+	NarrowPhaseType narrowPhaseType;
+	bool broadPhaseOncePerStep;
+	SweepAndPrune sweepAndPrune;
+	DynamicAABBTree aabbTree;
+	std::vector<int> treeProxies;   // tree proxy id for each body in bodyList
+	SpatialHashGrid spatialHash;
+	HierarchicalGrid hierarchicalGrid;
+	StaticBodyTree staticTree;
+	bool staticTreeDirty;
+	ThreadPool threadPool;
+	std::vector<PairBuffer> pairBuffers;   // one per thread
+	std::vector<AABB> bodyAABBs;
+
+
+	// Bodies are packed by slot, removal moves the last body into the hole
 	std::vector<std::shared_ptr<RigidBody2D>> bodyList;
+	// Hot state of the bodies in bodyList by the same slot, declared after it so it's
+	// destroyed first and can hand the state back to bodies that outlive the engine
+	BodyStore bodyStore;
+
+	struct HandleEntry {
+		int slot;                   // next free entry while the entry is in the free list
+		unsigned int generation;    // bumped on removal so old handles no longer match
+	};
+	std::vector<HandleEntry> handleEntries;
+	std::vector<int> slotToHandle;
+	int freeHandle;
+	// Where each body started and ended up in a removal batch or a reorder, kept with the
+	// Z curve codes to reuse the memory
+	std::vector<int> remapOldToNew;
+	std::vector<int> remapNewToOld;
+	std::vector<std::pair<unsigned int, int>> reorderCodes;
+	std::vector<unsigned char> reorderVisited;
+
+	AABB killBounds;
+	bool killBoundsEnabled;
+	bool findKilledBodies;      // set for the first bounds update of each Step
+	std::vector<BodyHandle> killedBodies;
+
+	int reorderInterval;
+	int stepsSinceReorder;
 	glm::vec2 gravity;
-	std::vector<ContactPair> contactPairs;
-	void SeperateBodies(std::shared_ptr<RigidBody2D> bodyA, std::shared_ptr<RigidBody2D> bodyB, glm::vec2 mtv);
+	// Pairs from the last broad phase search and one manifold per pair, all in frameArena
+	FrameArena frameArena;
+	ContactPair* contactPairs;
+	int contactPairCount;
+	CollisionManifold* manifolds;
+	int manifoldCount;
+	PairCache pairCache;
+	unsigned int nextBodyId;
+
+	EngineConfig config;
+	CapacityOverflow overflow;
+	int manifoldCapacity;   // manifolds the arena has room for this pass
+	void SeperateBodies(int slotA, int slotB, glm::vec2 mtv);
 };
\ No newline at end of file
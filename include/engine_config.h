@@ -0,0 +1,25 @@
+#pragma once
+
+// Storage an Engine2D sets aside when it's created. A limit of zero leaves that storage
+// to grow on demand. With fixedCapacity set the limits are hard: nothing is reallocated
+// after the engine is created, and whatever doesn't fit is left out and counted in
+// CapacityOverflow instead.
+struct EngineConfig {
+	int maxBodies;
+	int maxPairs;       // broad phase pairs per pass
+	int maxContacts;    // contact manifolds kept per pass
+	bool fixedCapacity;
+
+	EngineConfig() : maxBodies(0), maxPairs(0), maxContacts(0), fixedCapacity(false) {}
+};
+
+// What didn't fit with fixedCapacity set, counted since the engine was created or the
+// counters were last reset
+struct CapacityOverflow {
+	int bodies;     // bodies AddBody or SpawnBodies turned away
+	int pairs;      // broad phase pairs dropped, the bodies aren't tested that pass
+	int contacts;   // contacts that were resolved but not kept in the manifold list
+	int cells;      // spatial hash cell entries dropped, the bodies miss pairs in those cells
+
+	CapacityOverflow() : bodies(0), pairs(0), contacts(0), cells(0) {}
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that only lives for one Step, like the pair list and contact
+// manifolds. Allocating bumps an offset and Reset frees everything at once. When a step
+// needs more than the buffer holds the rest goes to overflow blocks, and the next Reset
+// grows the buffer to fit them, so once the arena has seen the peak nothing is allocated.
+// Only for trivially destructible types, destructors never run.
+class FrameArena {
+public:
+	FrameArena(std::size_t capacity = 64 * 1024);
+	~FrameArena();
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Returns uninitialized room for count objects, valid until the next Reset
+	template <typename T>
+	T* Allocate(int count);
+	void Reset();
+	// Grows the buffer to at least capacity bytes, only call it between steps
+	void Reserve(std::size_t capacity);
+
+	std::size_t GetCapacity() const { return capacity; }
+	std::size_t GetUsed() const { return offset + overflowSize; }
+
+private:
+	char* buffer;
+	std::size_t capacity;
+	std::size_t offset;
+
+	std::vector<void*> overflowBlocks;
+	std::size_t overflowSize;
+
+	void* AllocateBytes(std::size_t size, std::size_t alignment);
+};
+
+template <typename T>
+T* FrameArena::Allocate(int count) {
+	static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+	return static_cast<T*>(AllocateBytes(sizeof(T) * count, alignof(T)));
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+
+#include "aabb.h"
+#include "pair_buffer.h"
+
+// Broad phase for scenes that mix tiny and huge bodies. Cell sizes double from one level
+// to the next and each body goes into the single cell that holds its center, on the
+// lowest level whose cells are at least as big as the body. A body is only tested
+// against bodies on its own level and larger ones, and never looks at more than 3x3
+// cells per level, so the cost stays close to linear whatever the size spread.
+class HierarchicalGrid {
+public:
+	static const int MAX_LEVELS = 24;
+
+	HierarchicalGrid(float baseCellSize = 1.0f);
+
+	void AddBody(int index);
+	void Reserve(int count);
+	void Remap(const std::vector<int>& oldToNew);
+	void Clear();
+
+	void SetBaseCellSize(float size) { baseCellSize = size; }
+	float GetBaseCellSize() const { return baseCellSize; }
+
+	void Update(const std::vector<AABB>& bounds);
+	// Finds pairs for bodies [begin, end) of the grid against their own and larger levels
+	void FindPairs(int begin, int end, PairBuffer& pairs) const;
+	int GetBodyCount() const { return bodies.size(); }
+
+private:
+	struct CellEntry {
+		int level;
+		int cellX;
+		int cellY;
+		int body;
+	};
+
+	float baseCellSize;
+	float cellSizes[MAX_LEVELS];
+	unsigned int occupiedLevels;    // bit per level that has at least one body
+
+	std::vector<int> bodies;        // sorted body indices
+	std::vector<CellEntry> bodyCells;   // cell of each entry in bodies
+	const std::vector<AABB>* bounds;
+
+	std::vector<CellEntry> entries;     // grouped by bucket
+	std::vector<int> bucketStart;
+	std::vector<int> bucketFill;
+	unsigned int bucketMask;
+
+	static unsigned int HashCell(int level, int cellX, int cellY);
+	static int CellCoord(float value, float cellSize);
+};
@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+// Levels below LOG_MIN_LEVEL are stripped at compile time, their arguments aren't evaluated
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Logger::Get().Write(LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) Logger::Get().Write(LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) Logger::Get().Write(LogLevel::Warning, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Logger::Get().Write(LogLevel::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+enum class LogLevel : unsigned char {
+	Debug,
+	Info,
+	Warning,
+	Error
+};
+
+// Logging that never blocks the caller. Write only copies the format string pointer and
+// the arguments into a lock-free ring buffer, a background thread formats and prints
+// them. Each {} in the format is replaced by the next argument. The format must be a
+// string literal, string arguments are copied. When the buffer is full messages are
+// dropped and counted instead of waiting.
+class Logger {
+public:
+	static const int CAPACITY = 4096;      // messages, a power of two
+	static const int MAX_ARGS = 6;
+	static const int TEXT_SIZE = 64;       // room for the string arguments of one message
+
+	static Logger& Get();
+
+	~Logger();
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	template <typename... Args>
+	void Write(LogLevel level, const char* format, const Args&... args);
+
+private:
+	enum class ArgType : unsigned char {
+		Int,
+		UInt,
+		Float,
+		Text
+	};
+
+	struct Arg {
+		ArgType type;
+		union {
+			int64_t i;
+			uint64_t u;
+			double f;
+			int textOffset;
+		};
+	};
+
+	struct Record {
+		const char* format;
+		LogLevel level;
+		int argCount;
+		int textUsed;
+		Arg args[MAX_ARGS + 1];     // the last one takes arguments that don't fit
+		char text[TEXT_SIZE];
+
+		template <typename T>
+		typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type Add(T value) {
+			Arg& arg = Next(ArgType::Int);
+			arg.i = value;
+		}
+		template <typename T>
+		typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type Add(T value) {
+			Arg& arg = Next(ArgType::UInt);
+			arg.u = value;
+		}
+		template <typename T>
+		typename std::enable_if<std::is_floating_point<T>::value>::type Add(T value) {
+			Arg& arg = Next(ArgType::Float);
+			arg.f = value;
+		}
+		void Add(const char* value) { AddText(value, std::char_traits<char>::length(value)); }
+		void Add(const std::string& value) { AddText(value.data(), value.size()); }
+
+		Arg& Next(ArgType type);
+		void AddText(const char* value, std::size_t length);
+	};
+
+	// One slot of the ring buffer. sequence says whether the slot is ready to be written
+	// or read, so producers only ever race on the write position.
+	struct Cell {
+		std::atomic<std::size_t> sequence;
+		Record record;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	alignas(64) std::atomic<std::size_t> writePos;
+	alignas(64) std::size_t readPos;        // only the background thread reads
+	std::atomic<int> dropped;       // since the background thread last reported it
+	std::atomic<bool> stopping;
+	std::thread worker;
+
+	Logger();
+	bool Push(const Record& record);
+	bool Pop(Record& record);
+	void WorkerLoop();
+	// Formats and prints everything in the buffer, returns false if it was empty
+	bool Drain(std::string& line);
+	static void Format(const Record& record, std::string& line);
+};
+
+template <typename... Args>
+void Logger::Write(LogLevel level, const char* format, const Args&... args) {
+	Record record;
+	record.format = format;
+	record.level = level;
+	record.argCount = 0;
+	record.textUsed = 0;
+	int expand[] = { 0, (record.Add(args), 0)... };
+	(void)expand;
+
+	if (!Push(record)) {
+		dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
@@ -12,7 +12,8 @@ using namespace std;
 
 enum class ShapeType {
     Circle,
-    Square
+    Square,
+    ConvexPolygon
 };
 
 struct Vertex {
@@ -31,6 +32,10 @@ public:
 
     // constructor
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, ShapeType type);
+    // Frees the GL objects, so a mesh can't be copied and has to go before the GL context
+    ~Mesh();
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
 
     // render the mesh
     void Draw(Shader& shader, glm::mat4 trans, glm::vec3 color);
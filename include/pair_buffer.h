@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+
+#include "contact_pair.h"
+
+// Pairs found by one broad phase thread. Grows like a vector until a limit is set, then
+// pairs past the limit are counted instead of stored so the buffer never reallocates.
+class PairBuffer {
+public:
+	PairBuffer() : limit(-1), dropped(0) {}
+
+	void push_back(const ContactPair& pair) {
+		if (limit >= 0 && (int)pairs.size() >= limit) {
+			++dropped;
+			return;
+		}
+		pairs.push_back(pair);
+	}
+
+	void clear() {
+		pairs.clear();
+		dropped = 0;
+	}
+
+	int size() const { return pairs.size(); }
+	std::vector<ContactPair>::const_iterator begin() const { return pairs.begin(); }
+	std::vector<ContactPair>::const_iterator end() const { return pairs.end(); }
+
+	// Makes room for count pairs, with bounded set the buffer never holds more than that
+	void Reserve(int count, bool bounded) {
+		pairs.reserve(count);
+		limit = bounded ? count : -1;
+	}
+	// Pairs turned away since the last clear
+	int GetDroppedCount() const { return dropped; }
+
+private:
+	std::vector<ContactPair> pairs;
+	int limit;
+	int dropped;
+};
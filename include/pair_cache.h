@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+#include "collision_manifold.h"
+
+// Broad phase pairs that survive from one pass to the next. Pairs are keyed on the two
+// body ids so they stay the same when bodies are removed and the body list shifts.
+// A pair is Begin the first pass its bodies overlap, Persist while they keep overlapping
+// and End for one pass after they stop, then it is dropped.
+class PairCache {
+public:
+	enum class PairState {
+		Begin,
+		Persist,
+		End
+	};
+
+	struct Pair {
+		unsigned int idA;
+		unsigned int idB;
+		PairState state;
+		bool seen;          // found by the current broad phase pass
+
+		// Narrow phase results from the last substep, kept for warm starting and events
+		bool touching;
+		glm::vec2 normal;
+		float depth;
+		SimplexCache simplex;   // in idA, idB order
+	};
+
+	PairCache();
+
+	// Room for count pairs without growing the pair list or the lookup table
+	void Reserve(int count);
+
+	// Drops pairs that ended on the last pass and marks the rest as unseen
+	void BeginUpdate();
+	// Returns the index of the pair, valid until the next BeginUpdate
+	int AddPair(unsigned int idA, unsigned int idB);
+	// Pairs that weren't seen this pass become End
+	void EndUpdate();
+	void Clear();
+
+	int Find(unsigned int idA, unsigned int idB) const;
+
+	int GetPairCount() const { return pairs.size(); }
+	Pair& GetPair(int index) { return pairs[index]; }
+	const Pair& GetPair(int index) const { return pairs[index]; }
+
+private:
+	static const uint64_t EMPTY_KEY = ~0ull;
+
+	std::vector<Pair> pairs;
+
+	// Open addressing table from pair key to index in pairs
+	std::vector<uint64_t> keys;
+	std::vector<int> values;
+	unsigned int mask;
+
+	static uint64_t MakeKey(unsigned int idA, unsigned int idB);
+	unsigned int Slot(uint64_t key) const;
+	int FindSlot(uint64_t key) const;
+	void Grow();
+	void RemovePair(int index);
+};
@@ -5,6 +5,11 @@
 #include "glm/gtc/type_ptr.hpp"
 #include "mesh.h"
 #include "aabb.h"
+#include "body_store.h"
+#include "body_pool.h"
+#include "span.h"
+#include "transform_2D.h"
+#include "body_desc.h"
 
 #include <string>
 #include <random>
@@ -14,16 +19,45 @@
 
 
 class RigidBody2D {
+    friend class Engine2D;
+    friend class BodyStore;
+
+public:
+    static const int MAX_POLYGON_VERTICES = BodyDesc::MAX_VERTICES;
+
 private:
+    unsigned int id;    // assigned by Engine2D::AddBody, never reused
+
+    // Only used while the body isn't in an engine, otherwise the state lives in store at slot
     glm::vec2 position;
     glm::vec2 linearVelocity;
     float angle;
     float angularVelocity;
-    bool transformUpdateRequired;
-    bool aabbUpdateRequired;
+    float invMass;          // zero for static bodies
+    float invInertia;
+    unsigned char dirtyFlags;
+    BodyStore* store;
+    int slot;
+
+    glm::vec2& positionRef() { return store != nullptr ? store->position[slot] : position; }
+    glm::vec2& linearVelocityRef() { return store != nullptr ? store->linearVelocity[slot] : linearVelocity; }
+    float& angleRef() { return store != nullptr ? store->angle[slot] : angle; }
+    float& angularVelocityRef() { return store != nullptr ? store->angularVelocity[slot] : angularVelocity; }
+    unsigned char& dirtyFlagsRef() { return store != nullptr ? store->dirty[slot] : dirtyFlags; }
+
     AABB aabb;
 
-    glm::mat4 transformMatrix;
+    // Physics only needs position and rotation, the 4x4 matrix is built when drawing
+    Transform2D transform;
+
+    // Polygon around the body's centroid and its edge normals, set once at creation. The
+    // world normals are these rotated, edges are never rebuilt.
+    glm::vec2 localVertices[MAX_POLYGON_VERTICES];
+    glm::vec2 localNormals[MAX_POLYGON_VERTICES];
+    glm::vec2 worldVertices[MAX_POLYGON_VERTICES];
+    glm::vec2 worldNormals[MAX_POLYGON_VERTICES];
+    int polygonVertexCount;
+    void UpdateWorldVertices();
 
     glm::vec2 force;
 
@@ -31,26 +65,36 @@ private:
 
     static glm::vec3 getRandomColor();
 
+    template <typename... Args>
+    static std::shared_ptr<RigidBody2D> Allocate(const std::shared_ptr<BodyPool>& pool, Args&&... args);
+
     float CalculateRotationalInertia();
 
+    // Signed area and centroid of a polygon, the area is negative when it goes clockwise
+    static void CalculatePolygonArea(Span<glm::vec2> vertices, float& area, glm::vec2& centroid);
+    static bool IsConvex(Span<glm::vec2> vertices);
+
+    // Creates the body without checking the desc, see CheckBody
+    static std::shared_ptr<RigidBody2D> Build(const BodyDesc& desc, std::shared_ptr<Mesh> mesh, const std::shared_ptr<BodyPool>& pool);
+    static std::string getErrorMessage(BodyError error, ShapeType shapeType);
+
 
 public:
     RigidBody2D(glm::vec2 position, float density, float mass, float restitution, float area,
-        bool isStatic, float radius, float width, float height, ShapeType shapeType, glm::vec3 color, std::shared_ptr<Mesh> mesh);
+        bool isStatic, float radius, float width, float height, ShapeType shapeType, glm::vec3 color, std::shared_ptr<Mesh> mesh,
+        Span<glm::vec2> polygon = Span<glm::vec2>());
 
     const glm::vec3 color;
 
     const float density;
     const float mass;
-    float invMass;
     const float restitution;
     const float area;
     float inertia;
-    float invInertia;
 
     const bool isStatic;
 
-    const float radius;
+    const float radius;         // bounding radius for convex polygons
     const float width;
     const float height;
 
@@ -59,27 +103,51 @@ public:
 
     const ShapeType shapeType;
 
-    static bool CreateCircleBody(float radius, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage, std::shared_ptr<Mesh> mesh);
-    static bool CreateSquareBody(float width, float height, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage, std::shared_ptr<Mesh> mesh);
+    static BodyError CheckBody(const BodyDesc& desc);
+    // Bodies come from pool when one is given, otherwise from the heap
+    static BodyError CreateBody(const BodyDesc& desc, std::shared_ptr<RigidBody2D>& body, std::shared_ptr<Mesh> mesh,
+        const std::shared_ptr<BodyPool>& pool = nullptr);
+    static bool CreateCircleBody(float radius, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage, std::shared_ptr<Mesh> mesh,
+        const std::shared_ptr<BodyPool>& pool = nullptr);
+    static bool CreateSquareBody(float width, float height, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage, std::shared_ptr<Mesh> mesh,
+        const std::shared_ptr<BodyPool>& pool = nullptr);
+    // Up to MAX_POLYGON_VERTICES vertices relative to position, the polygon must be convex. There's
+    // no shared polygon mesh, create it through Engine2D to get one for drawing.
+    static bool CreatePolygonBody(const glm::vec2* vertices, int vertexCount, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage,
+        const std::shared_ptr<BodyPool>& pool = nullptr);
 
     void Move(glm::vec2 amount);
-    void MoveTo(glm::vec2 newPosition) { position = newPosition; }
+    void MoveTo(glm::vec2 newPosition) { positionRef() = newPosition; dirtyFlagsRef() = BodyStore::MOVED; }
     void Rotate(float amount);
 
+    unsigned int getId() const { return id; }
     float getWidth() const { return width; }
     float getRadius() const { return radius; }
-    glm::vec2 getLinearVelocity() const { return linearVelocity; }
+    float getBoundingRadius() const;
+    glm::vec2 getLinearVelocity() const { return store != nullptr ? store->linearVelocity[slot] : linearVelocity; }
     ShapeType getType() const { return shapeType;  }
-    float getAngle() const { return angle; }
-    glm::vec2 getPosition() const { return position; }
-    float getAngularVelocity() const { return angularVelocity; }
+    float getAngle() const { return store != nullptr ? store->angle[slot] : angle; }
+    glm::vec2 getPosition() const { return store != nullptr ? store->position[slot] : position; }
+    float getAngularVelocity() const { return store != nullptr ? store->angularVelocity[slot] : angularVelocity; }
+    float getInvMass() const { return store != nullptr ? store->invMass[slot] : invMass; }
+    float getInvInertia() const { return store != nullptr ? store->invInertia[slot] : invInertia; }
+    // Allocates a new vector every call, the collision code uses getWorldVertices instead
     vector<glm::vec4> getTransformedVertices();
+    // Polygon around the centroid in the body's own frame, empty for circles
+    Span<glm::vec2> getLocalVertices() const { return Span<glm::vec2>(localVertices, polygonVertexCount); }
+    // World space polygon kept with the body and only rebuilt after it moves, empty for circles
+    Span<glm::vec2> getWorldVertices();
+    // Vertices go counter clockwise, normal i is the outward unit normal of the edge from
+    // vertex i to vertex i + 1
+    Span<glm::vec2> getWorldNormals();
+    const Transform2D& getTransform();
+    // Built on every call, only for rendering
     glm::mat4 getTransformMatrix();
     
 
 
-    void setLinearVelocity(glm::vec2 newVelocity) { linearVelocity = newVelocity;  }
-    void setAngularVelocity(float newVelocity) { angularVelocity = newVelocity; }
+    void setLinearVelocity(glm::vec2 newVelocity) { linearVelocityRef() = newVelocity;  }
+    void setAngularVelocity(float newVelocity) { angularVelocityRef() = newVelocity; }
 
 
     void Step(float time, glm::vec2 gravity, int iterations);
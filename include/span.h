@@ -0,0 +1,18 @@
+#pragma once
+
+// Read-only view of count elements stored somewhere else, lets functions take a body's
+// inline arrays or part of a vector without copying
+template <typename T>
+struct Span {
+	const T* data;
+	int count;
+
+	Span() : data(nullptr), count(0) {}
+	Span(const T* data, int count) : data(data), count(count) {}
+
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+	const T& operator[](int i) const { return data[i]; }
+	const T* begin() const { return data; }
+	const T* end() const { return data + count; }
+};
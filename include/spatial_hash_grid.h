@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+
+#include "aabb.h"
+#include "pair_buffer.h"
+
+// Broad phase for piles of similar sized bodies. Each body is added to every cell its
+// AABB covers and pairs are only tested inside a cell. The grid is rebuilt every pass,
+// cells are hashed into a table sized from the body count so memory doesn't depend on
+// how far bodies spread out.
+class SpatialHashGrid {
+public:
+	static const int CELLS_PER_BODY = 4;
+
+	SpatialHashGrid(float cellSize = 32.0f);
+
+	void AddBody(int index);
+	// Room for count bodies covering CELLS_PER_BODY cells each on average. With bounded
+	// set no more cell entries than that are stored, the rest are counted and their
+	// pairs missed, since how many cells a body covers depends on its size.
+	void Reserve(int count, bool bounded);
+	// The cells are rebuilt from the renamed bodies on the next Update
+	void Remap(const std::vector<int>& oldToNew);
+	void Clear();
+
+	void SetCellSize(float size);
+	float GetCellSize() const { return cellSize; }
+
+	void Update(const std::vector<AABB>& bounds);
+	// Finds pairs in buckets [begin, end), a pair is reported from one bucket only
+	void FindPairs(int begin, int end, PairBuffer& pairs) const;
+	int GetBucketCount() const { return bucketStart.empty() ? 0 : bucketStart.size() - 1; }
+	// Cell entries turned away by the last Update
+	int GetDroppedCount() const { return dropped; }
+
+private:
+	struct CellEntry {
+		int cellX;
+		int cellY;
+		int body;
+	};
+
+	float cellSize;
+	float invCellSize;
+
+	std::vector<int> bodies;       // sorted body indices
+	const std::vector<AABB>* bounds;
+
+	std::vector<CellEntry> unsortedEntries;
+	std::vector<CellEntry> entries;        // grouped by bucket
+	std::vector<int> bucketStart;          // bucket i covers entries[bucketStart[i], bucketStart[i + 1])
+	std::vector<int> bucketFill;
+	int entryLimit;         // -1 when the entries can grow
+	int dropped;
+
+	int CellCoord(float value) const;
+	static unsigned int HashCell(int cellX, int cellY);
+};
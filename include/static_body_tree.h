@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+
+#include "aabb.h"
+
+// Bounding volume hierarchy for static bodies. It's built once from all static bodies
+// and never updated, moving bodies query it so level geometry is never tested against
+// itself and never re-sorted.
+class StaticBodyTree {
+public:
+	// Room for count bodies, so rebuilding the tree doesn't allocate
+	void Reserve(int count);
+	// Bodies added since the last Clear make up the tree once Build is called
+	void Add(int body, const AABB& box);
+	void Build();
+	// Only renames bodies, the tree keeps its shape
+	void Remap(const std::vector<int>& oldToNew);
+	void Clear();
+
+	bool IsEmpty() const { return nodes.empty(); }
+
+	// Calls callback(bodyIndex) for every static body whose AABB overlaps box, safe to call
+	// from several threads at once
+	template <typename T>
+	void Query(const AABB& box, T& callback) const;
+
+private:
+	static const int MAX_LEAF_SIZE = 4;
+	// Median splits give a depth of log2(n / MAX_LEAF_SIZE)
+	static const int QUERY_STACK_SIZE = 64;
+
+	struct Node {
+		AABB box;
+		int start;      // leaves hold items[start, start + count)
+		int count;      // 0 for inner nodes
+		int right;      // inner nodes store their left child right after themselves
+	};
+
+	struct Item {
+		AABB box;
+		glm::vec2 center;
+		int body;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<Item> items;
+
+	int BuildNode(int start, int end);
+};
+
+template <typename T>
+void StaticBodyTree::Query(const AABB& box, T& callback) const {
+	if (nodes.empty()) {
+		return;
+	}
+
+	int stack[QUERY_STACK_SIZE];
+	int stackCount = 0;
+	stack[stackCount++] = 0;
+
+	while (stackCount > 0) {
+		int nodeId = stack[--stackCount];
+
+		const Node& node = nodes[nodeId];
+
+		if (node.box.max.x <= box.min.x || box.max.x <= node.box.min.x ||
+			node.box.max.y <= box.min.y || box.max.y <= node.box.min.y) {
+			continue;
+		}
+
+		if (node.count > 0) {
+			for (int i = node.start; i < node.start + node.count; ++i) {
+				const AABB& itemBox = items[i].box;
+				if (itemBox.max.x <= box.min.x || box.max.x <= itemBox.min.x ||
+					itemBox.max.y <= box.min.y || box.max.y <= itemBox.min.y) {
+					continue;
+				}
+				callback(items[i].body);
+			}
+		}
+		else {
+			stack[stackCount++] = node.right;
+			stack[stackCount++] = nodeId + 1;
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+
+#include "aabb.h"
+#include "pair_buffer.h"
+
+// Broad phase that keeps bodies sorted along the x axis and only tests bodies whose
+// x intervals overlap. Bodies move little between steps, so the sort is kept up to date
+// with an insertion sort that runs in close to linear time.
+class SweepAndPrune {
+public:
+	void AddBody(int index);
+	void Reserve(int count);
+	// Keeps the sort order of the bodies that are left
+	void Remap(const std::vector<int>& oldToNew);
+	void Clear();
+
+	void Update(const std::vector<AABB>& bounds);
+	// Finds pairs for the bodies at sorted positions [begin, end)
+	void FindPairs(int begin, int end, PairBuffer& pairs) const;
+	int GetBodyCount() const { return order.size(); }
+
+private:
+	static const int BATCH_SIZE = 64;
+
+	std::vector<int> order;        // body indices sorted by min.x
+	AABBArray sortedBounds;        // bounds in the same order as order
+};
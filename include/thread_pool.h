@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Persistent worker threads for splitting a loop across cores. The calling thread
+// works too, so a pool with no workers just runs the loop inline.
+class ThreadPool {
+public:
+	ThreadPool();
+	~ThreadPool();
+
+	// Number of threads besides the caller
+	void SetThreadCount(int count);
+	int GetThreadCount() const { return workers.size(); }
+
+	// Splits [0, count) into ranges and calls task(thread, begin, end) on each of them.
+	// thread is in [0, GetThreadCount()] so callers can keep one buffer per thread.
+	void ParallelFor(int count, const std::function<void(int, int, int)>& task);
+
+private:
+	static const int MIN_RANGE = 64;
+	static const int RANGES_PER_THREAD = 4;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	const std::function<void(int, int, int)>* task;
+	int itemCount;
+	int rangeCount;
+	std::atomic<int> nextRange;
+	int busyWorkers;
+	int generation;
+	bool stopping;
+
+	void WorkerLoop(int thread, int lastGeneration);
+	void RunRanges(int thread);
+	void StopWorkers();
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <cmath>
+#include "glm/glm.hpp"
+
+// Position and rotation of a body. The rotation is kept as its cosine and sine, worked out
+// once when the angle changes, so moving a point into world space is four multiply-adds
+struct Transform2D {
+	glm::vec2 position;
+	float cos;
+	float sin;
+
+	Transform2D() : position(0.0f, 0.0f), cos(1.0f), sin(0.0f) {}
+	Transform2D(glm::vec2 position, float angle) : position(position), cos(std::cos(angle)), sin(std::sin(angle)) {}
+
+	glm::vec2 Rotate(glm::vec2 v) const { return glm::vec2(cos * v.x - sin * v.y, sin * v.x + cos * v.y); }
+	glm::vec2 InverseRotate(glm::vec2 v) const { return glm::vec2(cos * v.x + sin * v.y, -sin * v.x + cos * v.y); }
+
+	// Local space to world space and back
+	glm::vec2 Apply(glm::vec2 v) const { return position + Rotate(v); }
+	glm::vec2 ApplyInverse(glm::vec2 v) const { return InverseRotate(v - position); }
+};
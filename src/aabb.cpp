@@ -9,3 +9,49 @@ AABB::AABB(float minX, float minY, float maxX, float maxY) {
 	this->min = glm::vec2(minX, minY);
 	this->max = glm::vec2(maxX, maxY);
 }
+
+
+bool AABB::Contains(const AABB& other) const {
+	return min.x <= other.min.x && min.y <= other.min.y &&
+		max.x >= other.max.x && max.y >= other.max.y;
+}
+
+float AABB::Perimeter() const {
+	return 2.0f * ((max.x - min.x) + (max.y - min.y));
+}
+
+AABB AABB::Expanded(float amount) const {
+	return AABB(min - glm::vec2(amount, amount), max + glm::vec2(amount, amount));
+}
+
+AABB AABB::Combine(const AABB& a, const AABB& b) {
+	return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+}
+
+void AABBArray::Resize(int size) {
+	minX.resize(size);
+	minY.resize(size);
+	maxX.resize(size);
+	maxY.resize(size);
+}
+
+void AABBArray::Reserve(int count) {
+	minX.reserve(count);
+	minY.reserve(count);
+	maxX.reserve(count);
+	maxY.reserve(count);
+}
+
+void AABBArray::Clear() {
+	minX.clear();
+	minY.clear();
+	maxX.clear();
+	maxY.clear();
+}
+
+void AABBArray::Set(int index, const AABB& box) {
+	minX[index] = box.min.x;
+	minY[index] = box.min.y;
+	maxX[index] = box.max.x;
+	maxY[index] = box.max.y;
+}
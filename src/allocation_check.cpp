@@ -0,0 +1,89 @@
+#include "../include/allocation_check.h"
+
+#if defined(CHECK_ALLOCATIONS)
+#include "../include/engine_2D.h"
+#include "../include/collisions.h"
+#include "../include/logger.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long> allocationCount(0);
+
+void* operator new(std::size_t size) {
+	++allocationCount;
+	void* p = std::malloc(size == 0 ? 1 : size);
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+int CheckNarrowPhaseAllocations() {
+	Engine2D engine;
+	std::string errorMessage;
+	const glm::vec2 pentagon[] = { glm::vec2(0, 6), glm::vec2(-6, 2), glm::vec2(-4, -5), glm::vec2(4, -5), glm::vec2(6, 2) };
+
+	// Overlapping circles, boxes and polygons so every shape pair finds contacts
+	std::shared_ptr<RigidBody2D> bodies[6];
+	engine.CreateCircleBody(5.0f, glm::vec2(0, 9), 1.0f, false, 0.5f, bodies[0], errorMessage);
+	engine.CreateCircleBody(5.0f, glm::vec2(4, 12), 1.0f, false, 0.5f, bodies[1], errorMessage);
+	engine.CreateSquareBody(10.0f, 12.0f, glm::vec2(0, 0), 1.0f, false, 0.5f, bodies[2], errorMessage);
+	engine.CreateSquareBody(10.0f, 12.0f, glm::vec2(6, 3), 1.0f, true, 0.5f, bodies[3], errorMessage);
+	engine.CreatePolygonBody(pentagon, 5, glm::vec2(3, 6), 1.0f, false, 0.5f, bodies[4], errorMessage);
+	engine.CreatePolygonBody(pentagon, 5, glm::vec2(-3, 4), 1.0f, false, 0.5f, bodies[5], errorMessage);
+
+	long before = allocationCount;
+	int hits = 0;
+	for (int iteration = 0; iteration < 500; ++iteration) {
+		for (int i = 0; i < 6; ++i) {
+			// Rotating marks the cached world space vertices dirty, so they're rebuilt
+			bodies[i]->Rotate(0.01f);
+			for (int j = 0; j < 6; ++j) {
+				CollisionManifold contact;
+				if (i != j && Collisions::Collide(*bodies[i], *bodies[j], contact)) {
+					Collisions::FindContactPoints(*bodies[i], *bodies[j], contact);
+					++hits;
+				}
+			}
+		}
+	}
+	int narrowPhase = allocationCount - before;
+
+	// A settled pile, the first steps grow the engine's buffers to their peak
+	for (int i = 0; i < 200; ++i) {
+		std::shared_ptr<RigidBody2D> body;
+		if (engine.CreateCircleBody(3.0f, glm::vec2(i % 20 * 7.0f, i / 20 * 7.0f), 1.0f, false, 0.5f, body, errorMessage)) {
+			engine.AddBody(body);
+		}
+	}
+	std::shared_ptr<RigidBody2D> ground;
+	engine.CreateSquareBody(400.0f, 10.0f, glm::vec2(70.0f, -20.0f), 1.0f, true, 0.5f, ground, errorMessage);
+	engine.AddBody(ground);
+	for (int i = 0; i < 60; ++i) {
+		engine.Step(1.0f / 60.0f, 8);
+	}
+	before = allocationCount;
+	for (int i = 0; i < 60; ++i) {
+		engine.Step(1.0f / 60.0f, 8);
+	}
+	int steps = allocationCount - before;
+
+	if (narrowPhase != 0 || steps != 0) {
+		LOG_ERROR("{} allocations in {} narrow phase contacts, {} in 60 steps", narrowPhase, hits, steps);
+	}
+	else {
+		LOG_INFO("No allocations in {} narrow phase contacts or 60 steps", hits);
+	}
+	return narrowPhase + steps;
+}
+#endif
@@ -0,0 +1,66 @@
+#include "../include/body_pool.h"
+
+#include <new>
+
+const std::size_t BodyPool::CONTROL_BLOCK_SIZE;
+
+BodyPool::BodyPool(std::size_t objectSize) {
+	// Keep every block aligned like memory from operator new
+	std::size_t alignment = alignof(std::max_align_t);
+	blockSize = (objectSize + CONTROL_BLOCK_SIZE + alignment - 1) / alignment * alignment;
+	freeList = nullptr;
+	capacity = 0;
+	used = 0;
+}
+
+BodyPool::~BodyPool() {
+	for (int i = 0; i < chunks.size(); ++i) {
+		::operator delete(chunks[i]);
+	}
+}
+
+void BodyPool::AddChunk(int count) {
+	char* chunk = static_cast<char*>(::operator new(blockSize * count));
+	chunks.push_back(chunk);
+
+	// Thread the new blocks onto the free list, lowest address first
+	for (int i = count - 1; i >= 0; --i) {
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+		block->next = freeList;
+		freeList = block;
+	}
+	capacity += count;
+}
+
+void BodyPool::Reserve(int count) {
+	if (count > capacity) {
+		AddChunk(count - capacity);
+	}
+}
+
+void* BodyPool::Allocate(std::size_t size) {
+	if (size > blockSize) {
+		return ::operator new(size);
+	}
+
+	if (freeList == nullptr) {
+		AddChunk(CHUNK_SIZE);
+	}
+
+	FreeBlock* block = freeList;
+	freeList = block->next;
+	++used;
+	return block;
+}
+
+void BodyPool::Free(void* block, std::size_t size) {
+	if (size > blockSize) {
+		::operator delete(block);
+		return;
+	}
+
+	FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+	freeBlock->next = freeList;
+	freeList = freeBlock;
+	--used;
+}
@@ -0,0 +1,101 @@
+#include "../include/body_store.h"
+#include "../include/rigid_body_2D.h"
+
+const unsigned char BodyStore::TRANSFORM_DIRTY;
+const unsigned char BodyStore::AABB_DIRTY;
+const unsigned char BodyStore::VERTICES_DIRTY;
+const unsigned char BodyStore::MOVED;
+
+int BodyStore::Add(RigidBody2D* body) {
+	position.push_back(body->position);
+	linearVelocity.push_back(body->linearVelocity);
+	angle.push_back(body->angle);
+	angularVelocity.push_back(body->angularVelocity);
+	invMass.push_back(body->invMass);
+	invInertia.push_back(body->invInertia);
+	dirty.push_back(body->dirtyFlags);
+	bodies.push_back(body);
+
+	body->store = this;
+	body->slot = bodies.size() - 1;
+	return body->slot;
+}
+
+void BodyStore::Detach(int slot) {
+	RigidBody2D* body = bodies[slot];
+	body->position = position[slot];
+	body->linearVelocity = linearVelocity[slot];
+	body->angle = angle[slot];
+	body->angularVelocity = angularVelocity[slot];
+	body->dirtyFlags = dirty[slot];
+	body->store = nullptr;
+	body->slot = -1;
+}
+
+void BodyStore::Remove(int slot) {
+	Detach(slot);
+
+	int last = bodies.size() - 1;
+	if (slot != last) {
+		position[slot] = position[last];
+		linearVelocity[slot] = linearVelocity[last];
+		angle[slot] = angle[last];
+		angularVelocity[slot] = angularVelocity[last];
+		invMass[slot] = invMass[last];
+		invInertia[slot] = invInertia[last];
+		dirty[slot] = dirty[last];
+		bodies[slot] = bodies[last];
+		bodies[slot]->slot = slot;
+	}
+
+	position.pop_back();
+	linearVelocity.pop_back();
+	angle.pop_back();
+	angularVelocity.pop_back();
+	invMass.pop_back();
+	invInertia.pop_back();
+	dirty.pop_back();
+	bodies.pop_back();
+}
+
+void BodyStore::Permute(const std::vector<int>& newToOld) {
+	PermuteInPlace(position, newToOld, permuteVisited);
+	PermuteInPlace(linearVelocity, newToOld, permuteVisited);
+	PermuteInPlace(angle, newToOld, permuteVisited);
+	PermuteInPlace(angularVelocity, newToOld, permuteVisited);
+	PermuteInPlace(invMass, newToOld, permuteVisited);
+	PermuteInPlace(invInertia, newToOld, permuteVisited);
+	PermuteInPlace(dirty, newToOld, permuteVisited);
+	PermuteInPlace(bodies, newToOld, permuteVisited);
+
+	for (int i = 0; i < bodies.size(); ++i) {
+		bodies[i]->slot = i;
+	}
+}
+
+void BodyStore::Clear() {
+	for (int i = 0; i < bodies.size(); ++i) {
+		Detach(i);
+	}
+
+	position.clear();
+	linearVelocity.clear();
+	angle.clear();
+	angularVelocity.clear();
+	invMass.clear();
+	invInertia.clear();
+	dirty.clear();
+	bodies.clear();
+}
+
+void BodyStore::Reserve(int count) {
+	position.reserve(count);
+	linearVelocity.reserve(count);
+	angle.reserve(count);
+	angularVelocity.reserve(count);
+	invMass.reserve(count);
+	invInertia.reserve(count);
+	dirty.reserve(count);
+	bodies.reserve(count);
+	permuteVisited.reserve(count);
+}
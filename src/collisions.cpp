@@ -1,28 +1,58 @@
 #include "../include/collisions.h"
-// Checks for type of bodies and calls the respective intersection function
-bool Collisions::Collide(std::shared_ptr<RigidBody2D> bodyA, std::shared_ptr<RigidBody2D> bodyB, glm::vec2& normal, float& depth) {
-    ShapeType shapeTypeA = bodyA->getType();
-    ShapeType shapeTypeB = bodyB->getType();
 
-    if (shapeTypeA == ShapeType::Square) {
-        if (shapeTypeB == ShapeType::Square) {
-            return Collisions::IntersectPolygons(bodyA->getTransformedVertices(), bodyB->getTransformedVertices(), bodyA->getPosition(), bodyB->getPosition(), normal, depth);
+#include <algorithm>
+
+const float Collisions::CONTACT_TOLERANCE = 0.05f;
+const float Collisions::REFERENCE_EDGE_BIAS = 0.001f;
+const float Collisions::GJK_TOLERANCE = 0.0001f;
+const float Collisions::EPA_TOLERANCE = 0.001f;
+const int Collisions::GJK_MAX_ITERATIONS;
+const int Collisions::EPA_MAX_VERTICES;
+
+// Checks for type of bodies and calls the respective intersection function. Squares and convex
+// polygons are both polygons, two squares take the box fast path. Sets the normal and depth of
+// contact, and the contact point when the test finds it along the way
+bool Collisions::Collide(RigidBody2D& bodyA, RigidBody2D& bodyB, CollisionManifold& contact) {
+    ShapeType shapeTypeA = bodyA.getType();
+    ShapeType shapeTypeB = bodyB.getType();
+    contact.contactCount = 0;
+
+    if (shapeTypeA != ShapeType::Circle) {
+        if (shapeTypeA == ShapeType::Square && shapeTypeB == ShapeType::Square) {
+            Transform2D transformA = bodyA.getTransform();
+            Transform2D transformB = bodyB.getTransform();
+            return Collisions::IntersectBoxes(transformA, glm::vec2(bodyA.width, bodyA.height) * 0.5f,
+                transformB, glm::vec2(bodyB.width, bodyB.height) * 0.5f, contact.normal, contact.depth);
         }
-        if (shapeTypeB == ShapeType::Circle) {
-            bool result = Collisions::IntersectCirclePolygon(bodyB->getPosition(), bodyB->getRadius(), bodyA->getTransformedVertices(), bodyA->getPosition(), normal, depth);
-            normal = -normal;
-            return result;
+        if (shapeTypeB != ShapeType::Circle) {
+            return Collisions::IntersectPolygons(bodyA.getWorldVertices(), bodyA.getWorldNormals(), bodyB.getWorldVertices(), bodyB.getWorldNormals(),
+                bodyA.getTransform().position, bodyB.getTransform().position, contact.normal, contact.depth);
         }
+        if (!Collisions::IntersectCirclePolygon(bodyB.getTransform().position, bodyB.getRadius(), bodyA.getWorldVertices(), bodyA.getWorldNormals(),
+            contact.normal, contact.depth, contact.contactOne)) {
+            return false;
+        }
+        contact.normal = -contact.normal;
+        contact.contactCount = 1;
+        return true;
     }
-    else if (shapeTypeA == ShapeType::Circle) {
-        if (shapeTypeB == ShapeType::Square) {
-            return Collisions::IntersectCirclePolygon(bodyA->getPosition(), bodyA->getRadius(), bodyB->getTransformedVertices(), bodyB->getPosition(), normal, depth);
+    else {
+        if (shapeTypeB != ShapeType::Circle) {
+            if (!Collisions::IntersectCirclePolygon(bodyA.getTransform().position, bodyA.getRadius(), bodyB.getWorldVertices(), bodyB.getWorldNormals(),
+                contact.normal, contact.depth, contact.contactOne)) {
+                return false;
+            }
+            contact.contactCount = 1;
+            return true;
         }
-        if (shapeTypeB == ShapeType::Circle) {
-            return Collisions::IntersectCircles(bodyA->getPosition(), bodyA->getRadius(), bodyB->getPosition(), bodyB->getRadius(), normal, depth);
+        if (!Collisions::IntersectCircles(bodyA.getTransform().position, bodyA.getRadius(), bodyB.getTransform().position, bodyB.getRadius(),
+            contact.normal, contact.depth)) {
+            return false;
         }
+        Collisions::FindContactPoint(bodyA.getTransform().position, bodyA.getRadius(), bodyB.getTransform().position, contact.contactOne);
+        contact.contactCount = 1;
+        return true;
     }
-
 }
 
 bool Collisions::IntersectCircles(glm::vec2 centerA, float radiusA, glm::vec2 centerB, float radiusB,
@@ -40,87 +70,116 @@ bool Collisions::IntersectCircles(glm::vec2 centerA, float radiusA, glm::vec2 ce
 
 	return true;
 }
-bool Collisions::IntersectCirclePolygon(glm::vec2 circleCenter, float circleRadius, vector<glm::vec4> vertices, glm::vec2 polyCenter, glm::vec2& normal, float& depth) {
-    normal = glm::vec2(0.0f, 0.0f);
-    depth = FLT_MAX;
-    float axisDepth = 0;
-    float minA, maxA, minB, maxB;
-    glm::vec2 axis = glm::vec2(0.0f, 0.0f);
+// Circle against polygon by Voronoi regions. One pass over the edges finds the edge the circle
+// center is furthest in front of, stopping early if it's further than the radius. The center
+// is then either inside the polygon, over that edge or past one of its ends, and each case
+// gives the normal, depth and contact point directly.
+bool Collisions::IntersectCirclePolygon(glm::vec2 circleCenter, float circleRadius, Span<glm::vec2> vertices, Span<glm::vec2> normals,
+    glm::vec2& normal, float& depth, glm::vec2& contactPoint) {
+    int edge = 0;
+    float separation = -FLT_MAX;
 
-    // Check all edges of the polygon
     for (int i = 0; i < vertices.size(); ++i) {
-        glm::vec2 va = glm::vec2(vertices[i].x, vertices[i].y);
-        glm::vec2 vb = glm::vec2(vertices[(i + 1) % vertices.size()].x, vertices[(i + 1) % vertices.size()].y);
-
-        glm::vec2 edge = vb - va;
-        axis = glm::normalize(glm::vec2(-edge.y, edge.x));  // Perpendicular axis to the edge
+        float s = glm::dot(normals[i], circleCenter - vertices[i]);
 
-        // Project vertices onto the axis
-        Collisions::ProjectVertices(vertices, axis, minA, maxA);
-        Collisions::ProjectCircle(circleCenter, circleRadius, axis, minB, maxB);
-
-        if (minA >= maxB || minB >= maxA) {
-            return false;  // No intersection on this axis, return false
+        if (s > circleRadius) {
+            return false;  // This edge separates them
+        }
+        if (s > separation) {
+            separation = s;
+            edge = i;
         }
+    }
 
-        // Calculate the overlap on the axis
-        axisDepth = std::min(maxB - minA, maxA - minB);
+    glm::vec2 v1 = vertices[edge];
+    glm::vec2 v2 = vertices[(edge + 1) % vertices.size()];
+    glm::vec2 edgeNormal = normals[edge];
 
-        if (axisDepth < depth) {
-            depth = axisDepth;  // Update depth if the current axis gives a smaller overlap
-            normal = axis;  // Update normal to the current axis
+    // Normals point from the circle to the polygon
+    if (separation > 0.0f) {
+        if (glm::dot(circleCenter - v1, v2 - v1) <= 0.0f) {
+            return IntersectCircleVertex(circleCenter, circleRadius, v1, normal, depth, contactPoint);
+        }
+        if (glm::dot(circleCenter - v2, v1 - v2) <= 0.0f) {
+            return IntersectCircleVertex(circleCenter, circleRadius, v2, normal, depth, contactPoint);
         }
     }
 
-    // Find the closest point on the polygon to the circle's center
-    int cpIndex = Collisions::FindClosestPointOnPolygon(circleCenter, vertices);
-    glm::vec2 cp = vertices[cpIndex];
-
-    // Calculate the normal from the circle's center to the closest point
-    axis = cp - circleCenter;
-    axis = glm::normalize(axis);
+    // Over the edge or inside the polygon, the edge is the closest feature either way
+    normal = -edgeNormal;
+    depth = circleRadius - separation;
+    contactPoint = circleCenter - edgeNormal * separation;
+    return true;
+}
 
-    // Project vertices onto the axis for the closest point check
-    Collisions::ProjectVertices(vertices, axis, minA, maxA);
-    Collisions::ProjectCircle(circleCenter, circleRadius, axis, minB, maxB);
+bool Collisions::IntersectCircleVertex(glm::vec2 circleCenter, float circleRadius, glm::vec2 vertex, glm::vec2& normal, float& depth, glm::vec2& contactPoint) {
+    glm::vec2 toVertex = vertex - circleCenter;
+    float distanceSquared = glm::dot(toVertex, toVertex);
 
-    if (minA >= maxB || minB >= maxA) {
-        return false;  // No intersection, return false
+    if (distanceSquared >= circleRadius * circleRadius) {
+        return false;
     }
 
-    axisDepth = std::min(maxB - minA, maxA - minB);
+    float distance = std::sqrt(distanceSquared);
+    normal = toVertex / distance;
+    depth = circleRadius - distance;
+    contactPoint = vertex;
+    return true;
+}
 
-    // Update the depth and normal if a closer overlap is found
-    if (axisDepth < depth) {
-        depth = axisDepth;
-        normal = axis;
-    }
+// Oriented box against oriented box. Each box only has two unique axes, the columns of its
+// rotation, and they're unit length already. A box's extent along an axis is its half extents
+// dotted with the absolute axis in the box's frame, so no vertices are projected.
+bool Collisions::IntersectBoxes(const Transform2D& transformA, glm::vec2 halfExtentsA, const Transform2D& transformB, glm::vec2 halfExtentsB,
+    glm::vec2& normal, float& depth) {
+    glm::vec2 axesA[2] = { glm::vec2(transformA.cos, transformA.sin), glm::vec2(-transformA.sin, transformA.cos) };
+    glm::vec2 axesB[2] = { glm::vec2(transformB.cos, transformB.sin), glm::vec2(-transformB.sin, transformB.cos) };
+    glm::vec2 direction = transformB.position - transformA.position;
+
+    // B's axes in A's frame, the same absolute values serve both directions
+    float c00 = std::abs(glm::dot(axesA[0], axesB[0]));
+    float c01 = std::abs(glm::dot(axesA[0], axesB[1]));
+    float c10 = std::abs(glm::dot(axesA[1], axesB[0]));
+    float c11 = std::abs(glm::dot(axesA[1], axesB[1]));
+
+    float radiiA[4] = {
+        halfExtentsA.x,
+        halfExtentsA.y,
+        halfExtentsA.x * c00 + halfExtentsA.y * c10,
+        halfExtentsA.x * c01 + halfExtentsA.y * c11
+    };
+    float radiiB[4] = {
+        halfExtentsB.x * c00 + halfExtentsB.y * c01,
+        halfExtentsB.x * c10 + halfExtentsB.y * c11,
+        halfExtentsB.x,
+        halfExtentsB.y
+    };
+    glm::vec2 axes[4] = { axesA[0], axesA[1], axesB[0], axesB[1] };
 
-    // Check the orientation of the normal (if necessary)
-    //glm::vec2 polygonCenter = Collisions::FindArethmeticMean(vertices);
-    glm::vec2 polygonCenter = polyCenter;
-    glm::vec2 direction = polygonCenter - circleCenter;
+    depth = FLT_MAX;
+    for (int i = 0; i < 4; ++i) {
+        float distance = glm::dot(direction, axes[i]);
+        float axisDepth = radiiA[i] + radiiB[i] - std::abs(distance);
 
-    // If the normal is pointing inward, reverse it
-    if (glm::dot(direction, normal) < 0.0f) {
-        normal = -normal;
+        if (axisDepth <= 0.0f) {
+            return false;  // Separating axis found
+        }
+
+        if (axisDepth < depth) {
+            depth = axisDepth;
+            normal = distance < 0.0f ? -axes[i] : axes[i];  // Points from A to B
+        }
     }
 
-    return true;  // Return true if intersection is detected
+    return true;
 }
-bool Collisions::IntersectPolygons(vector<glm::vec4> verticesA, vector<glm::vec4> verticesB, glm::vec2 polyCenterA, glm::vec2 polyCenterB, glm::vec2& normal, float& depth) {
+bool Collisions::IntersectPolygons(Span<glm::vec2> verticesA, Span<glm::vec2> normalsA, Span<glm::vec2> verticesB, Span<glm::vec2> normalsB,
+    glm::vec2 polyCenterA, glm::vec2 polyCenterB, glm::vec2& normal, float& depth) {
     normal = glm::vec2(0.0f, 0.0f);
     depth = FLT_MAX;
 
     for (int i = 0; i < verticesA.size(); ++i) {
-        glm::vec2 va = glm::vec2(verticesA[i].x, verticesA[i].y);
-        glm::vec2 vb = glm::vec2(verticesA[(i + 1) % verticesA.size()].x, verticesA[(i + 1) % verticesA.size()].y);
-
-        glm::vec2 edge = vb - va;
-        glm::vec2 axis = glm::vec2(-edge.y, edge.x);  // Perpendicular axis to the edge
-
-        // Normalize axis
-        axis = glm::normalize(axis);
+        glm::vec2 axis = normalsA[i];  // Perpendicular axis to the edge
 
         float minA, maxA, minB, maxB;
 
@@ -143,14 +202,7 @@ bool Collisions::IntersectPolygons(vector<glm::vec4> verticesA, vector<glm::vec4
 
     // Check for each edge in polygon B
     for (int i = 0; i < verticesB.size(); ++i) {
-        glm::vec2 va = glm::vec2(verticesB[i].x, verticesB[i].y);
-        glm::vec2 vb = glm::vec2(verticesB[(i + 1) % verticesB.size()].x, verticesB[(i + 1) % verticesB.size()].y);
-
-        glm::vec2 edge = vb - va;
-        glm::vec2 axis = glm::vec2(-edge.y, edge.x);  // Perpendicular axis to the edge
-
-        // Normalize axis
-        axis = glm::normalize(axis);
+        glm::vec2 axis = normalsB[i];  // Perpendicular axis to the edge
 
         float minA, maxA, minB, maxB;
 
@@ -185,46 +237,12 @@ bool Collisions::IntersectPolygons(vector<glm::vec4> verticesA, vector<glm::vec4
     return true;  // Return true if intersection was found
 }
 
-// Helper methods for intersection detection
-int Collisions::FindClosestPointOnPolygon(glm::vec2 circleCenter, vector<glm::vec4> vertices) {
-    int result = -1;
-    float minDistance = FLT_MAX;
-
-    // Iterate over all vertices to find the closest one to the circle center
-    for (int i = 0; i < vertices.size(); ++i) {
-        glm::vec2 v = vertices[i];
-        float distance = glm::distance(v, circleCenter);
-
-        // Update the closest point if a smaller distance is found
-        if (distance < minDistance) {
-            minDistance = distance;
-            result = i;
-        }
-    }
-    return result;
-}
-void Collisions::ProjectCircle(glm::vec2 center, float radius, glm::vec2 axis, float& min, float& max) {
-    glm::vec2 direction = glm::normalize(axis);
-    glm::vec2 directionAndRadius = direction * radius;
-
-    glm::vec2 p1 = center + directionAndRadius;
-    glm::vec2 p2 = center - directionAndRadius;
-
-    min = glm::dot(p1, axis);
-    max = glm::dot(p2, axis);
-
-    if (min > max) {
-        float t = min;
-        min = max;
-        max = t;
-    }
-}
-void Collisions::ProjectVertices(vector<glm::vec4> vertices, glm::vec2 axis, float& min, float& max) {
-	float proj = glm::dot(glm::vec2(vertices[0].x, vertices[0].y), axis);
+void Collisions::ProjectVertices(Span<glm::vec2> vertices, glm::vec2 axis, float& min, float& max) {
+	float proj = glm::dot(vertices[0], axis);
 	min = max = proj;  
 
 	for (int i = 1; i < vertices.size(); ++i) {
-		glm::vec2 v = glm::vec2(vertices[i].x, vertices[i].y);
+		glm::vec2 v = vertices[i];
 		proj = glm::dot(v, axis);
 
 		if (proj < min) { min = proj; }
@@ -232,108 +250,143 @@ void Collisions::ProjectVertices(vector<glm::vec4> vertices, glm::vec2 axis, flo
 	}
 }
 
-// Method for finding where two bodies collide, finds body type and calls respective function
-void Collisions::FindContactPoints(std::shared_ptr<RigidBody2D> bodyA, std::shared_ptr<RigidBody2D> bodyB, glm::vec2& contactOne, glm::vec2& contactTwo, int& contactCount) {
-    ShapeType shapeTypeA = bodyA->getType();
-    ShapeType shapeTypeB = bodyB->getType();
+// Finds the contact points Collide didn't, contact's normal must already be set. Only polygon
+// pairs are left, anything with a circle gets its contact point from the intersection test.
+void Collisions::FindContactPoints(RigidBody2D& bodyA, RigidBody2D& bodyB, CollisionManifold& contact) {
+    contact.featureOne = ContactFeature();
+    contact.featureTwo = ContactFeature();
 
-    if (shapeTypeA == ShapeType::Square) {
-        if (shapeTypeB == ShapeType::Square) {
-            Collisions::FindContactPoint(bodyA->getTransformedVertices(), bodyB->getTransformedVertices(), contactOne, contactTwo, contactCount);
-        }
-        if (shapeTypeB == ShapeType::Circle) {
-            Collisions::FindContactPoint(bodyB->getPosition(), bodyB->getRadius(), bodyA->getPosition(), bodyA->getTransformedVertices(), contactOne);
-            contactCount = 1;
-        }
-    }
-    else if (shapeTypeA == ShapeType::Circle) {
-        if (shapeTypeB == ShapeType::Square) {
-            Collisions::FindContactPoint(bodyA->getPosition(), bodyA->getRadius(), bodyB->getPosition(), bodyB->getTransformedVertices(), contactOne);
-            contactCount = 1;
-        }
-        if (shapeTypeB == ShapeType::Circle) {
-            Collisions::FindContactPoint(bodyA->getPosition(), bodyA->getRadius(), bodyB->getPosition(), contactOne);
-            contactCount = 1;
-        }
+    if (bodyA.getType() != ShapeType::Circle && bodyB.getType() != ShapeType::Circle) {
+        Collisions::ClipPolygons(bodyA.getWorldVertices(), bodyA.getWorldNormals(), bodyB.getWorldVertices(), bodyB.getWorldNormals(), contact);
     }
 }
 
-//Polygon to Polygon collision points
-void Collisions::FindContactPoint(vector<glm::vec4> verticesA, vector<glm::vec4> verticesB, glm::vec2& contact1, glm::vec2& contact2, int& contactCount) {
-    contact1 = glm::vec2(0.0f, 0.0f);
-    contact2 = glm::vec2(0.0f, 0.0f);
-    contactCount = 0;
+// Polygon to polygon contact points, the incident edge clipped to the reference edge
+void Collisions::ClipPolygons(Span<glm::vec2> verticesA, Span<glm::vec2> normalsA, Span<glm::vec2> verticesB, Span<glm::vec2> normalsB,
+    CollisionManifold& contact) {
+    glm::vec2 normal = contact.normal;
+
+    // The reference edge is the one facing the other body most directly, ties go to A so
+    // the choice doesn't flip back and forth between steps
+    int edgeA = FindMostAlignedEdge(normalsA, normal);
+    int edgeB = FindMostAlignedEdge(normalsB, -normal);
+    bool flip = glm::dot(normalsB[edgeB], -normal) > glm::dot(normalsA[edgeA], normal) + REFERENCE_EDGE_BIAS;
+
+    Span<glm::vec2> refVertices = flip ? verticesB : verticesA;
+    Span<glm::vec2> incVertices = flip ? verticesA : verticesB;
+    Span<glm::vec2> incNormals = flip ? normalsA : normalsB;
+    int refEdge = flip ? edgeB : edgeA;
+    glm::vec2 refNormal = flip ? normalsB[edgeB] : normalsA[edgeA];
+
+    // The incident edge faces back against the reference edge
+    int incEdge = FindMostAlignedEdge(incNormals, -refNormal);
+
+    ClipVertex incident[2];
+    incident[0].point = incVertices[incEdge];
+    incident[1].point = incVertices[(incEdge + 1) % incVertices.size()];
+    for (int i = 0; i < 2; ++i) {
+        incident[i].feature.referenceEdge = refEdge;
+        incident[i].feature.incidentEdge = incEdge;
+        incident[i].feature.point = i;
+        incident[i].feature.flip = flip ? 1 : 0;
+    }
 
-    float minDistSq = FLT_MAX;
+    glm::vec2 refStart = refVertices[refEdge];
+    glm::vec2 refEnd = refVertices[(refEdge + 1) % refVertices.size()];
+    glm::vec2 tangent = glm::normalize(refEnd - refStart);
 
-    for (int i = 0; i < verticesA.size(); ++i) {
-        glm::vec2 p = verticesA[i];
-
-        for (int j = 0; j < verticesB.size(); ++j) {
-            glm::vec2 va = verticesB[j];
-            glm::vec2 vb = verticesB[(j + 1) % verticesB.size()];
-            float distSq;
-            glm::vec2 cp;
-
-            Collisions::PointSegmentDistance(p, va, vb, distSq, cp);
-
-            if (std::abs(distSq - minDistSq) < 0.01f) {
-                //cout << " cp.x is " << cp.x << " contact1.x is " << contact1.x << " cp.y is " << cp.y << " contact1.y is " << contact1.y << endl;
-                if (std::abs(cp.x - contact1.x) > .01 || std::abs(cp.y - contact1.y) > .01){
-                    contact2 = cp;
-                    contactCount = 2;
-                }
-            }
-            else if (distSq < minDistSq) {
-                minDistSq = distSq;
-                contactCount = 1;
-                contact1 = cp;
+    // Clip against the side planes through both ends of the reference edge
+    ClipVertex clipped1[2];
+    ClipVertex clipped2[2];
+    int count = ClipSegment(incident, clipped1, -tangent, -glm::dot(tangent, refStart), 2);
+    if (count == 2) {
+        count = ClipSegment(clipped1, clipped2, tangent, glm::dot(tangent, refEnd), 3);
+    }
+
+    if (count < 2) {
+        // The incident edge misses the reference edge's span, happens when corners meet
+        // at an angle, use the deepest incident vertex
+        int deepest = 0;
+        float minSeparation = FLT_MAX;
+        for (int i = 0; i < incVertices.size(); ++i) {
+            float separation = glm::dot(refNormal, incVertices[i] - refStart);
+            if (separation < minSeparation) {
+                minSeparation = separation;
+                deepest = i;
             }
         }
+        contact.contactOne = incVertices[deepest];
+        contact.featureOne.referenceEdge = refEdge;
+        contact.featureOne.incidentEdge = deepest;
+        contact.featureOne.flip = flip ? 1 : 0;
+        contact.contactCount = 1;
+        return;
     }
 
-    for (int i = 0; i < verticesB.size(); ++i) {
-        glm::vec2 p = verticesB[i];
-
-        for (int j = 0; j < verticesA.size(); ++j) {
-            glm::vec2 va = verticesA[j];
-            glm::vec2 vb = verticesA[(j + 1) % verticesA.size()];
-            float distSq;
-            glm::vec2 cp;
-
-            Collisions::PointSegmentDistance(p, va, vb, distSq, cp);
+    // Keep the clipped points that are on or below the reference edge. The bodies were
+    // just separated, so a small tolerance keeps both points of a flat contact.
+    float separation0 = glm::dot(refNormal, clipped2[0].point - refStart);
+    float separation1 = glm::dot(refNormal, clipped2[1].point - refStart);
+    contact.contactCount = 0;
+    if (separation0 <= CONTACT_TOLERANCE) {
+        contact.contactOne = clipped2[0].point;
+        contact.featureOne = clipped2[0].feature;
+        contact.contactCount = 1;
+    }
+    if (separation1 <= CONTACT_TOLERANCE) {
+        if (contact.contactCount == 0) {
+            contact.contactOne = clipped2[1].point;
+            contact.featureOne = clipped2[1].feature;
+        }
+        else {
+            contact.contactTwo = clipped2[1].point;
+            contact.featureTwo = clipped2[1].feature;
+        }
+        ++contact.contactCount;
+    }
+    if (contact.contactCount == 0) {
+        int deepest = separation0 <= separation1 ? 0 : 1;
+        contact.contactOne = clipped2[deepest].point;
+        contact.featureOne = clipped2[deepest].feature;
+        contact.contactCount = 1;
+    }
+}
 
-            if (std::abs(distSq - minDistSq) < .01f) {
-                if (std::abs(cp.x - contact1.x) > .01 || std::abs(cp.y - contact1.y) > .01) {
-                    contact2 = cp;
-                    contactCount = 2;
-                }
-            }
-            else if (distSq < minDistSq) {
-                minDistSq = distSq;
-                contactCount = 1;
-                contact1 = cp;
-            }
+int Collisions::FindMostAlignedEdge(Span<glm::vec2> normals, glm::vec2 direction) {
+    int best = 0;
+    float bestDot = -FLT_MAX;
+    for (int i = 0; i < normals.size(); ++i) {
+        float d = glm::dot(normals[i], direction);
+        if (d > bestDot) {
+            bestDot = d;
+            best = i;
         }
     }
+    return best;
 }
 
-// Polygon to Circle collision point
-void Collisions::FindContactPoint(glm::vec2 circleCenter, float circleRadius, glm::vec2 polygonCenter, vector<glm::vec4> polygonVertices, glm::vec2& collisionPoint) {
-    float minDistSq = FLT_MAX;
-    for (int i = 0; i < polygonVertices.size(); ++i) {
-        glm::vec2 va = polygonVertices[i];
-        glm::vec2 vb = polygonVertices[(i + 1) % polygonVertices.size()];
+// Keeps the part of the segment where dot(normal, p) <= offset, new points are tagged with sidePoint
+int Collisions::ClipSegment(const ClipVertex in[2], ClipVertex out[2], glm::vec2 normal, float offset, unsigned char sidePoint) {
+    int count = 0;
 
-        float distanceSquared;
-        glm::vec2 contact;
-        Collisions::PointSegmentDistance(circleCenter, va, vb, distanceSquared, contact);
+    float distance0 = glm::dot(normal, in[0].point) - offset;
+    float distance1 = glm::dot(normal, in[1].point) - offset;
 
-        if (distanceSquared < minDistSq) {
-            minDistSq = distanceSquared;
-            collisionPoint = contact;
-        }
+    if (distance0 <= 0.0f) {
+        out[count++] = in[0];
     }
+    if (distance1 <= 0.0f) {
+        out[count++] = in[1];
+    }
+
+    if (distance0 * distance1 < 0.0f) {
+        float t = distance0 / (distance0 - distance1);
+        out[count].point = in[0].point + t * (in[1].point - in[0].point);
+        out[count].feature = distance0 > 0.0f ? in[0].feature : in[1].feature;
+        out[count].feature.point = sidePoint;
+        ++count;
+    }
+    return count;
 }
 
 // Helper Function
@@ -366,6 +419,423 @@ void Collisions::FindContactPoint(glm::vec2 centerA, float radiusA, glm::vec2 ce
     contactPoint = centerA + (dir * radiusA);
 }
 
+bool Collisions::CollideConvex(RigidBody2D& bodyA, RigidBody2D& bodyB, CollisionManifold& contact, SimplexCache& cache) {
+    ConvexProxy proxyA = MakeProxy(bodyA);
+    ConvexProxy proxyB = MakeProxy(bodyB);
+    contact.contactCount = 0;
+
+    glm::vec2 contactPoint;
+    if (!Collisions::IntersectConvex(proxyA, proxyB, cache, contact.normal, contact.depth, contactPoint)) {
+        return false;
+    }
+
+    // Two polygons are left for FindContactPoints to clip, one point isn't enough to rest on
+    if (bodyA.getType() == ShapeType::Circle || bodyB.getType() == ShapeType::Circle) {
+        contact.contactOne = contactPoint;
+        contact.contactCount = 1;
+    }
+    return true;
+}
+
+Collisions::ConvexProxy Collisions::MakeProxy(RigidBody2D& body) {
+    ConvexProxy proxy;
+    if (body.getType() == ShapeType::Circle) {
+        proxy.vertices = Span<glm::vec2>(&body.getTransform().position, 1);
+        proxy.radius = body.getRadius();
+    }
+    else {
+        proxy.vertices = body.getWorldVertices();
+        proxy.radius = 0.0f;
+    }
+    return proxy;
+}
+
+int Collisions::ConvexProxy::Support(glm::vec2 direction) const {
+    int best = 0;
+    float bestDot = glm::dot(vertices[0], direction);
+    for (int i = 1; i < vertices.size(); ++i) {
+        float d = glm::dot(vertices[i], direction);
+        if (d > bestDot) {
+            bestDot = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+Collisions::SimplexVertex Collisions::MakeSimplexVertex(const ConvexProxy& proxyA, const ConvexProxy& proxyB, int indexA, int indexB) {
+    SimplexVertex vertex;
+    vertex.indexA = indexA;
+    vertex.indexB = indexB;
+    vertex.pointA = proxyA.vertices[indexA];
+    vertex.pointB = proxyB.vertices[indexB];
+    vertex.point = vertex.pointB - vertex.pointA;
+    vertex.weight = 1.0f;
+    return vertex;
+}
+
+bool Collisions::IntersectConvex(const ConvexProxy& proxyA, const ConvexProxy& proxyB, SimplexCache& cache,
+    glm::vec2& normal, float& depth, glm::vec2& contactPoint) {
+    SimplexVertex simplex[3];
+    int count = 0;
+
+    // Start from the cached simplex when its vertices still exist and haven't collapsed
+    for (int i = 0; i < cache.count; ++i) {
+        if (cache.indexA[i] >= proxyA.vertices.size() || cache.indexB[i] >= proxyB.vertices.size()) {
+            count = 0;
+            break;
+        }
+        simplex[count++] = MakeSimplexVertex(proxyA, proxyB, cache.indexA[i], cache.indexB[i]);
+    }
+    if (count == 2) {
+        glm::vec2 e12 = simplex[1].point - simplex[0].point;
+        if (glm::dot(e12, e12) < GJK_TOLERANCE * GJK_TOLERANCE) {
+            count = 1;
+        }
+    }
+    else if (count == 3) {
+        glm::vec2 e12 = simplex[1].point - simplex[0].point;
+        glm::vec2 e13 = simplex[2].point - simplex[0].point;
+        if (std::abs(e12.x * e13.y - e12.y * e13.x) < GJK_TOLERANCE * GJK_TOLERANCE) {
+            count = 1;
+        }
+    }
+    if (count == 0) {
+        simplex[0] = MakeSimplexVertex(proxyA, proxyB, 0, 0);
+        count = 1;
+    }
+
+    for (int iteration = 0; iteration < GJK_MAX_ITERATIONS; ++iteration) {
+        int savedA[3];
+        int savedB[3];
+        int savedCount = count;
+        for (int i = 0; i < count; ++i) {
+            savedA[i] = simplex[i].indexA;
+            savedB[i] = simplex[i].indexB;
+        }
+
+        count = SolveSimplex(simplex, count);
+        if (count == 3) {
+            break;  // The origin is inside, the cores overlap
+        }
+
+        // Towards the origin from the closest point of the simplex
+        glm::vec2 direction;
+        if (count == 1) {
+            direction = -simplex[0].point;
+        }
+        else {
+            glm::vec2 e12 = simplex[1].point - simplex[0].point;
+            float side = e12.x * -simplex[0].point.y - e12.y * -simplex[0].point.x;
+            direction = side > 0.0f ? glm::vec2(-e12.y, e12.x) : glm::vec2(e12.y, -e12.x);
+        }
+        if (glm::dot(direction, direction) < FLT_EPSILON * FLT_EPSILON) {
+            break;  // The origin is on the simplex
+        }
+
+        SimplexVertex vertex = MakeSimplexVertex(proxyA, proxyB, proxyA.Support(-direction), proxyB.Support(direction));
+
+        // No new support point means this is as close as it gets
+        bool duplicate = false;
+        for (int i = 0; i < savedCount; ++i) {
+            if (vertex.indexA == savedA[i] && vertex.indexB == savedB[i]) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            break;
+        }
+        simplex[count++] = vertex;
+    }
+
+    cache.count = count;
+    for (int i = 0; i < count; ++i) {
+        cache.indexA[i] = simplex[i].indexA;
+        cache.indexB[i] = simplex[i].indexB;
+    }
+
+    glm::vec2 pointA(0.0f, 0.0f);
+    glm::vec2 pointB(0.0f, 0.0f);
+    for (int i = 0; i < count; ++i) {
+        pointA += simplex[i].weight * simplex[i].pointA;
+        pointB += simplex[i].weight * simplex[i].pointB;
+    }
+
+    float radii = proxyA.radius + proxyB.radius;
+    float distance = glm::distance(pointA, pointB);
+
+    if (count < 3 && distance > GJK_TOLERANCE) {
+        // The cores are apart, the shapes only touch if their radii make up the gap
+        if (distance >= radii) {
+            return false;
+        }
+        normal = (pointB - pointA) / distance;
+        depth = radii - distance;
+    }
+    else {
+        ExpandPolytope(proxyA, proxyB, simplex, count, normal, depth, pointA);
+        depth += radii;
+    }
+    contactPoint = pointA + normal * proxyA.radius;
+    return true;
+}
+
+int Collisions::SolveSimplex(SimplexVertex simplex[3], int count) {
+    if (count == 1) {
+        simplex[0].weight = 1.0f;
+        return 1;
+    }
+
+    glm::vec2 w1 = simplex[0].point;
+    glm::vec2 w2 = simplex[1].point;
+    glm::vec2 e12 = w2 - w1;
+
+    // d12_1 and d12_2 are the unnormalized barycentric weights on the segment w1 w2
+    float d12_1 = glm::dot(w2, e12);
+    float d12_2 = -glm::dot(w1, e12);
+
+    if (count == 2) {
+        if (d12_2 <= 0.0f) {
+            simplex[0].weight = 1.0f;
+            return 1;
+        }
+        if (d12_1 <= 0.0f) {
+            simplex[0] = simplex[1];
+            simplex[0].weight = 1.0f;
+            return 1;
+        }
+        float inv = 1.0f / (d12_1 + d12_2);
+        simplex[0].weight = d12_1 * inv;
+        simplex[1].weight = d12_2 * inv;
+        return 2;
+    }
+
+    glm::vec2 w3 = simplex[2].point;
+    glm::vec2 e13 = w3 - w1;
+    glm::vec2 e23 = w3 - w2;
+
+    float d13_1 = glm::dot(w3, e13);
+    float d13_2 = -glm::dot(w1, e13);
+    float d23_1 = glm::dot(w3, e23);
+    float d23_2 = -glm::dot(w2, e23);
+
+    // Triangle weights, each the area opposite a vertex with the triangle's winding
+    float n123 = e12.x * e13.y - e12.y * e13.x;
+    float d123_1 = n123 * (w2.x * w3.y - w2.y * w3.x);
+    float d123_2 = n123 * (w3.x * w1.y - w3.y * w1.x);
+    float d123_3 = n123 * (w1.x * w2.y - w1.y * w2.x);
+
+    // Check the vertex regions, then the edge regions, then the inside
+    if (d12_2 <= 0.0f && d13_2 <= 0.0f) {
+        simplex[0].weight = 1.0f;
+        return 1;
+    }
+    if (d12_1 > 0.0f && d12_2 > 0.0f && d123_3 <= 0.0f) {
+        float inv = 1.0f / (d12_1 + d12_2);
+        simplex[0].weight = d12_1 * inv;
+        simplex[1].weight = d12_2 * inv;
+        return 2;
+    }
+    if (d13_1 > 0.0f && d13_2 > 0.0f && d123_2 <= 0.0f) {
+        float inv = 1.0f / (d13_1 + d13_2);
+        simplex[0].weight = d13_1 * inv;
+        simplex[1] = simplex[2];
+        simplex[1].weight = d13_2 * inv;
+        return 2;
+    }
+    if (d12_1 <= 0.0f && d23_2 <= 0.0f) {
+        simplex[0] = simplex[1];
+        simplex[0].weight = 1.0f;
+        return 1;
+    }
+    if (d13_1 <= 0.0f && d23_1 <= 0.0f) {
+        simplex[0] = simplex[2];
+        simplex[0].weight = 1.0f;
+        return 1;
+    }
+    if (d23_1 > 0.0f && d23_2 > 0.0f && d123_1 <= 0.0f) {
+        float inv = 1.0f / (d23_1 + d23_2);
+        simplex[0] = simplex[2];
+        simplex[0].weight = d23_2 * inv;
+        simplex[1].weight = d23_1 * inv;
+        return 2;
+    }
+
+    float inv = 1.0f / (d123_1 + d123_2 + d123_3);
+    simplex[0].weight = d123_1 * inv;
+    simplex[1].weight = d123_2 * inv;
+    simplex[2].weight = d123_3 * inv;
+    return 3;
+}
+
+void Collisions::ExpandPolytope(const ConvexProxy& proxyA, const ConvexProxy& proxyB, const SimplexVertex* simplex, int count,
+    glm::vec2& normal, float& depth, glm::vec2& pointA) {
+    SimplexVertex polytope[EPA_MAX_VERTICES];
+    int size = count;
+    for (int i = 0; i < count; ++i) {
+        polytope[i] = simplex[i];
+    }
+
+    // GJK stops on a point or a segment when the cores only just touch, grow it into a
+    // triangle by searching away from what's there
+    const glm::vec2 directions[4] = { glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec2(-1.0f, 0.0f), glm::vec2(0.0f, -1.0f) };
+    for (int i = 0; i < 4 && size == 1; ++i) {
+        polytope[1] = MakeSimplexVertex(proxyA, proxyB, proxyA.Support(-directions[i]), proxyB.Support(directions[i]));
+        glm::vec2 offset = polytope[1].point - polytope[0].point;
+        if (glm::dot(offset, offset) > GJK_TOLERANCE * GJK_TOLERANCE) {
+            size = 2;
+        }
+    }
+    if (size == 2) {
+        glm::vec2 edge = polytope[1].point - polytope[0].point;
+        glm::vec2 side(-edge.y, edge.x);
+        for (int i = 0; i < 2 && size == 2; ++i) {
+            glm::vec2 direction = i == 0 ? side : -side;
+            polytope[2] = MakeSimplexVertex(proxyA, proxyB, proxyA.Support(-direction), proxyB.Support(direction));
+            glm::vec2 offset = polytope[2].point - polytope[0].point;
+            if (std::abs(edge.x * offset.y - edge.y * offset.x) > GJK_TOLERANCE * glm::length(edge)) {
+                size = 3;
+            }
+        }
+    }
+
+    if (size < 3) {
+        // Both cores are the same point or lie along one line, any direction is as good
+        normal = size == 2 ? glm::normalize(glm::vec2(polytope[1].point.y - polytope[0].point.y, polytope[0].point.x - polytope[1].point.x)) : glm::vec2(0.0f, 1.0f);
+        depth = 0.0f;
+        pointA = polytope[0].pointA;
+        return;
+    }
+
+    // Counter clockwise so each edge's outward normal is (edge.y, -edge.x)
+    glm::vec2 e12 = polytope[1].point - polytope[0].point;
+    glm::vec2 e13 = polytope[2].point - polytope[0].point;
+    if (e12.x * e13.y - e12.y * e13.x < 0.0f) {
+        std::swap(polytope[1], polytope[2]);
+    }
+
+    int edge = 0;
+    glm::vec2 edgeNormal(0.0f, 1.0f);
+    float distance = 0.0f;
+    while (true) {
+        distance = FLT_MAX;
+        for (int i = 0; i < size; ++i) {
+            glm::vec2 e = polytope[(i + 1) % size].point - polytope[i].point;
+            float length = glm::length(e);
+            if (length < GJK_TOLERANCE) {
+                continue;
+            }
+            glm::vec2 n = glm::vec2(e.y, -e.x) / length;
+            float d = glm::dot(n, polytope[i].point);
+            if (d < distance) {
+                distance = d;
+                edge = i;
+                edgeNormal = n;
+            }
+        }
+
+        SimplexVertex vertex = MakeSimplexVertex(proxyA, proxyB, proxyA.Support(-edgeNormal), proxyB.Support(edgeNormal));
+        if (glm::dot(vertex.point, edgeNormal) - distance < EPA_TOLERANCE || size == EPA_MAX_VERTICES) {
+            break;
+        }
+
+        for (int i = size; i > edge + 1; --i) {
+            polytope[i] = polytope[i - 1];
+        }
+        polytope[edge + 1] = vertex;
+        ++size;
+
+        // GJK can start from points inside B - A rather than on it, like the first vertices or
+        // a stale cache. Drop any the new point leaves in a dent, that only grows the polytope
+        // so the origin stays inside.
+        for (int i = 0; i < size && size > 3;) {
+            glm::vec2 a = polytope[(i + size - 1) % size].point;
+            glm::vec2 b = polytope[i].point;
+            glm::vec2 c = polytope[(i + 1) % size].point;
+            if ((b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x) > 0.0f) {
+                ++i;
+                continue;
+            }
+            for (int j = i; j + 1 < size; ++j) {
+                polytope[j] = polytope[j + 1];
+            }
+            --size;
+            i = 0;
+        }
+    }
+
+    // The closest point of the edge to the origin gives the support points on each body
+    const SimplexVertex& v1 = polytope[edge];
+    const SimplexVertex& v2 = polytope[(edge + 1) % size];
+    glm::vec2 e = v2.point - v1.point;
+    float t = glm::clamp(-glm::dot(v1.point, e) / glm::dot(e, e), 0.0f, 1.0f);
+
+    // B has to move against the polytope's normal to get out of A
+    normal = -edgeNormal;
+    depth = distance;
+    pointA = v1.pointA + t * (v2.pointA - v1.pointA);
+}
+
+bool Collisions::OverlapAABBs(const AABB& a, const AABB& b) {
+    return a.max.x > b.min.x && b.max.x > a.min.x && a.max.y > b.min.y && b.max.y > a.min.y;
+}
+
+int Collisions::OverlapAABBBatch(const AABB& box, const AABBArray& boxes, int begin, int end, int* hits) {
+    int count = 0;
+    int i = begin;
+
+#if defined(COLLISIONS_AVX)
+    __m256 boxMinX8 = _mm256_set1_ps(box.min.x);
+    __m256 boxMinY8 = _mm256_set1_ps(box.min.y);
+    __m256 boxMaxX8 = _mm256_set1_ps(box.max.x);
+    __m256 boxMaxY8 = _mm256_set1_ps(box.max.y);
+
+    for (; i + 8 <= end; i += 8) {
+        __m256 overlapX = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&boxes.minX[i]), boxMaxX8, _CMP_LT_OQ),
+                                        _mm256_cmp_ps(_mm256_loadu_ps(&boxes.maxX[i]), boxMinX8, _CMP_GT_OQ));
+        __m256 overlapY = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&boxes.minY[i]), boxMaxY8, _CMP_LT_OQ),
+                                        _mm256_cmp_ps(_mm256_loadu_ps(&boxes.maxY[i]), boxMinY8, _CMP_GT_OQ));
+        int mask = _mm256_movemask_ps(_mm256_and_ps(overlapX, overlapY));
+
+        for (int bit = 0; mask != 0; ++bit, mask >>= 1) {
+            if (mask & 1) {
+                hits[count++] = i + bit;
+            }
+        }
+    }
+#endif
+
+#if defined(COLLISIONS_SSE2)
+    __m128 boxMinX = _mm_set1_ps(box.min.x);
+    __m128 boxMinY = _mm_set1_ps(box.min.y);
+    __m128 boxMaxX = _mm_set1_ps(box.max.x);
+    __m128 boxMaxY = _mm_set1_ps(box.max.y);
+
+    for (; i + 4 <= end; i += 4) {
+        __m128 overlapX = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(&boxes.minX[i]), boxMaxX),
+                                     _mm_cmpgt_ps(_mm_loadu_ps(&boxes.maxX[i]), boxMinX));
+        __m128 overlapY = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(&boxes.minY[i]), boxMaxY),
+                                     _mm_cmpgt_ps(_mm_loadu_ps(&boxes.maxY[i]), boxMinY));
+        int mask = _mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+
+        for (int bit = 0; mask != 0; ++bit, mask >>= 1) {
+            if (mask & 1) {
+                hits[count++] = i + bit;
+            }
+        }
+    }
+#endif
+
+    for (; i < end; ++i) {
+        if (boxes.minX[i] < box.max.x && boxes.maxX[i] > box.min.x &&
+            boxes.minY[i] < box.max.y && boxes.maxY[i] > box.min.y) {
+            hits[count++] = i;
+        }
+    }
+    return count;
+}
+
 bool Collisions::IntersectAABBs(AABB a, AABB b) {
     if (a.max.x <= b.min.x || b.max.x <= a.min.x) {
         return true;
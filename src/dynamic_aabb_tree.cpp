@@ -0,0 +1,291 @@
+#include "../include/dynamic_aabb_tree.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+const int DynamicAABBTree::NULL_NODE;
+
+DynamicAABBTree::DynamicAABBTree(float margin) {
+	this->margin = margin;
+	root = NULL_NODE;
+	freeList = NULL_NODE;
+}
+
+int DynamicAABBTree::AllocateNode() {
+	if (freeList == NULL_NODE) {
+		TreeNode node;
+		node.parent = NULL_NODE;
+		nodes.push_back(node);
+		freeList = nodes.size() - 1;
+	}
+
+	int nodeId = freeList;
+	freeList = nodes[nodeId].parent;
+
+	TreeNode& node = nodes[nodeId];
+	node.parent = NULL_NODE;
+	node.child1 = NULL_NODE;
+	node.child2 = NULL_NODE;
+	node.userData = -1;
+	node.height = 0;
+	return nodeId;
+}
+
+void DynamicAABBTree::FreeNode(int nodeId) {
+	nodes[nodeId].parent = freeList;
+	nodes[nodeId].height = -1;
+	freeList = nodeId;
+}
+
+void DynamicAABBTree::Clear() {
+	nodes.clear();
+	root = NULL_NODE;
+	freeList = NULL_NODE;
+}
+
+int DynamicAABBTree::CreateProxy(const AABB& box, int userData) {
+	int proxyId = AllocateNode();
+	nodes[proxyId].box = box.Expanded(margin);
+	nodes[proxyId].userData = userData;
+	InsertLeaf(proxyId);
+	return proxyId;
+}
+
+void DynamicAABBTree::DestroyProxy(int proxyId) {
+	RemoveLeaf(proxyId);
+	FreeNode(proxyId);
+}
+
+bool DynamicAABBTree::MoveProxy(int proxyId, const AABB& box) {
+	if (nodes[proxyId].box.Contains(box)) {
+		return false;
+	}
+
+	RemoveLeaf(proxyId);
+	nodes[proxyId].box = box.Expanded(margin);
+	InsertLeaf(proxyId);
+	return true;
+}
+
+void DynamicAABBTree::InsertLeaf(int leaf) {
+	if (root == NULL_NODE) {
+		root = leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	// Walk down the tree picking the child that grows the total perimeter the least
+	AABB leafBox = nodes[leaf].box;
+	int index = root;
+	while (!nodes[index].IsLeaf()) {
+		int child1 = nodes[index].child1;
+		int child2 = nodes[index].child2;
+
+		float area = nodes[index].box.Perimeter();
+		float combinedArea = AABB::Combine(nodes[index].box, leafBox).Perimeter();
+
+		// Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+		// Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float cost1 = AABB::Combine(leafBox, nodes[child1].box).Perimeter() + inheritanceCost;
+		if (!nodes[child1].IsLeaf()) {
+			cost1 -= nodes[child1].box.Perimeter();
+		}
+		float cost2 = AABB::Combine(leafBox, nodes[child2].box).Perimeter() + inheritanceCost;
+		if (!nodes[child2].IsLeaf()) {
+			cost2 -= nodes[child2].box.Perimeter();
+		}
+
+		if (cost < cost1 && cost < cost2) {
+			break;
+		}
+
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	int sibling = index;
+
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = AABB::Combine(leafBox, nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE) {
+		if (nodes[oldParent].child1 == sibling) {
+			nodes[oldParent].child1 = newParent;
+		}
+		else {
+			nodes[oldParent].child2 = newParent;
+		}
+	}
+	else {
+		root = newParent;
+	}
+
+	// Walk back up fixing heights and boxes
+	index = nodes[leaf].parent;
+	while (index != NULL_NODE) {
+		index = Balance(index);
+
+		int child1 = nodes[index].child1;
+		int child2 = nodes[index].child2;
+		nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+		nodes[index].box = AABB::Combine(nodes[child1].box, nodes[child2].box);
+
+		index = nodes[index].parent;
+	}
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf) {
+	if (leaf == root) {
+		root = NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent != NULL_NODE) {
+		// Replace the parent with the sibling
+		if (nodes[grandParent].child1 == parent) {
+			nodes[grandParent].child1 = sibling;
+		}
+		else {
+			nodes[grandParent].child2 = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		int index = grandParent;
+		while (index != NULL_NODE) {
+			index = Balance(index);
+
+			int child1 = nodes[index].child1;
+			int child2 = nodes[index].child2;
+			nodes[index].box = AABB::Combine(nodes[child1].box, nodes[child2].box);
+			nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+
+			index = nodes[index].parent;
+		}
+	}
+	else {
+		root = sibling;
+		nodes[sibling].parent = NULL_NODE;
+		FreeNode(parent);
+	}
+}
+
+// Performs a left or right rotation if node A is imbalanced, returns the new subtree root
+int DynamicAABBTree::Balance(int iA) {
+	TreeNode& A = nodes[iA];
+	if (A.IsLeaf() || A.height < 2) {
+		return iA;
+	}
+
+	int iB = A.child1;
+	int iC = A.child2;
+	TreeNode& B = nodes[iB];
+	TreeNode& C = nodes[iC];
+
+	int balance = C.height - B.height;
+
+	// Rotate C up
+	if (balance > 1) {
+		int iF = C.child1;
+		int iG = C.child2;
+		TreeNode& F = nodes[iF];
+		TreeNode& G = nodes[iG];
+
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		if (C.parent != NULL_NODE) {
+			if (nodes[C.parent].child1 == iA) {
+				nodes[C.parent].child1 = iC;
+			}
+			else {
+				nodes[C.parent].child2 = iC;
+			}
+		}
+		else {
+			root = iC;
+		}
+
+		if (F.height > G.height) {
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.box = AABB::Combine(B.box, G.box);
+			C.box = AABB::Combine(A.box, F.box);
+			A.height = 1 + std::max(B.height, G.height);
+			C.height = 1 + std::max(A.height, F.height);
+		}
+		else {
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.box = AABB::Combine(B.box, F.box);
+			C.box = AABB::Combine(A.box, G.box);
+			A.height = 1 + std::max(B.height, F.height);
+			C.height = 1 + std::max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	// Rotate B up
+	if (balance < -1) {
+		int iD = B.child1;
+		int iE = B.child2;
+		TreeNode& D = nodes[iD];
+		TreeNode& E = nodes[iE];
+
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		if (B.parent != NULL_NODE) {
+			if (nodes[B.parent].child1 == iA) {
+				nodes[B.parent].child1 = iB;
+			}
+			else {
+				nodes[B.parent].child2 = iB;
+			}
+		}
+		else {
+			root = iB;
+		}
+
+		if (D.height > E.height) {
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.box = AABB::Combine(C.box, E.box);
+			B.box = AABB::Combine(A.box, D.box);
+			A.height = 1 + std::max(C.height, E.height);
+			B.height = 1 + std::max(A.height, D.height);
+		}
+		else {
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.box = AABB::Combine(C.box, D.box);
+			B.box = AABB::Combine(A.box, E.box);
+			A.height = 1 + std::max(C.height, D.height);
+			B.height = 1 + std::max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
@@ -1,13 +1,48 @@
 #include "../include/engine_2D.h"
 
+#include <algorithm>
+
 const float Engine2D::MAX_BODY_SIZE = 640.0f * 64.0f;
 const float Engine2D::MIN_BODY_SIZE = 0.01f;
 const float Engine2D::MIN_DENSITY = 0.5f;    // g/cm^3
 const float Engine2D::MAX_DENSITY = 21.4f;
+const float Engine2D::SWEPT_AABB_MARGIN = 2.0f;
 
-Engine2D::Engine2D() {
+Engine2D::Engine2D(const EngineConfig& config) : config(config) {
 	gravity = glm::vec2(0.0f, -980.665f);
+	broadPhaseType = BroadPhaseType::SweepAndPrune;
+	narrowPhaseType = NarrowPhaseType::SAT;
+	staticTreeDirty = true;
+	broadPhaseOncePerStep = true;
+	nextBodyId = 0;
+	freeHandle = -1;
+	contactPairs = nullptr;
+	contactPairCount = 0;
+	manifolds = nullptr;
+	manifoldCount = 0;
+	manifoldCapacity = 0;
+	killBoundsEnabled = false;
+	findKilledBodies = false;
+	reorderInterval = 0;
+	stepsSinceReorder = 0;
+	bodyPool = std::make_shared<BodyPool>(sizeof(RigidBody2D));
 	createMeshes();
+
+	if (config.maxBodies > 0) {
+		ReserveBodies(config.maxBodies);
+	}
+
+	pairBuffers.resize(threadPool.GetThreadCount() + 1);
+	if (config.maxPairs > 0) {
+		for (int i = 0; i < pairBuffers.size(); ++i) {
+			pairBuffers[i].Reserve(config.maxPairs, config.fixedCapacity);
+		}
+		// Pairs that ended stay in the cache for one more pass
+		pairCache.Reserve(2 * config.maxPairs);
+
+		int maxManifolds = config.maxContacts > 0 ? config.maxContacts : config.maxPairs;
+		frameArena.Reserve(config.maxPairs * sizeof(ContactPair) + maxManifolds * sizeof(CollisionManifold) + 2 * alignof(std::max_align_t));
+	}
 }
 
 void Engine2D::createMeshes() {
@@ -76,18 +111,259 @@ void Engine2D::Draw(Shader& shader, glm::mat4 proj) {
 		else if (currBody->shapeType == ShapeType::Circle) {
 			meshes[ShapeType::Circle]->Draw(shader, trans, currBody->color);
 		}
+		else if (currBody->shapeType == ShapeType::ConvexPolygon && currBody->mesh != nullptr) {
+			currBody->mesh->Draw(shader, trans, currBody->color);
+		}
+	}
+}
+
+std::shared_ptr<Mesh> Engine2D::getPolygonMesh(const RigidBody2D& body) {
+	int count = body.polygonVertexCount;
+	int unused = -1;
+	for (int i = 0; i < polygonMeshes.size(); ++i) {
+		PolygonMesh& entry = polygonMeshes[i];
+		if (entry.vertexCount == count && std::equal(body.localVertices, body.localVertices + count, entry.vertices)) {
+			return entry.mesh;
+		}
+		// Only the cache holds it
+		if (unused == -1 && entry.mesh.use_count() == 1) {
+			unused = i;
+		}
+	}
+
+	if (unused == -1) {
+		unused = polygonMeshes.size();
+		polygonMeshes.push_back(PolygonMesh());
+	}
+	PolygonMesh& entry = polygonMeshes[unused];
+	entry.vertexCount = count;
+	std::copy(body.localVertices, body.localVertices + count, entry.vertices);
+
+	// The local polygon as a triangle fan
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	for (int i = 0; i < count; ++i) {
+		vertices.push_back({ glm::vec3(body.localVertices[i], 0.0f), glm::vec3(0.0f, 0.0f, 0.0f) });
+	}
+	for (int i = 1; i + 1 < count; ++i) {
+		indices.push_back(0);
+		indices.push_back(i);
+		indices.push_back(i + 1);
+	}
+	entry.mesh = std::make_shared<Mesh>(vertices, indices, ShapeType::ConvexPolygon);
+	return entry.mesh;
+}
+
+
+bool Engine2D::CreateCircleBody(float radius, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage) {
+	return RigidBody2D::CreateCircleBody(radius, position, density, isStatic, restitution, body, errorMessage, meshes[ShapeType::Circle], bodyPool);
+}
+
+bool Engine2D::CreateSquareBody(float width, float height, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage) {
+	return RigidBody2D::CreateSquareBody(width, height, position, density, isStatic, restitution, body, errorMessage, meshes[ShapeType::Square], bodyPool);
+}
+
+bool Engine2D::CreatePolygonBody(const glm::vec2* vertices, int vertexCount, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage) {
+	if (!RigidBody2D::CreatePolygonBody(vertices, vertexCount, position, density, isStatic, restitution, body, errorMessage, bodyPool)) {
+		return false;
+	}
+	body->mesh = getPolygonMesh(*body);
+	return true;
+}
+
+void Engine2D::ReserveBodies(int count) {
+	bodyPool->Reserve(count);
+	bodyList.reserve(count);
+	bodyStore.Reserve(count);
+	handleEntries.reserve(count);
+	slotToHandle.reserve(count);
+	remapOldToNew.reserve(count);
+	remapNewToOld.reserve(count);
+	reorderCodes.reserve(count);
+	reorderVisited.reserve(count);
+	killedBodies.reserve(count);
+	bodyAABBs.reserve(count);
+	staticTree.Reserve(count);
+	ReserveBroadPhase(count);
+}
+
+void Engine2D::ReserveBroadPhase(int count) {
+	switch (broadPhaseType) {
+	case BroadPhaseType::SweepAndPrune:
+		sweepAndPrune.Reserve(count);
+		break;
+	case BroadPhaseType::AABBTree:
+		aabbTree.Reserve(count);
+		treeProxies.reserve(count);
+		break;
+	case BroadPhaseType::SpatialHash:
+		spatialHash.Reserve(count, config.fixedCapacity);
+		break;
+	case BroadPhaseType::HierarchicalGrid:
+		hierarchicalGrid.Reserve(count);
+		break;
+	default:
+		break;
+	}
+}
+
+bool Engine2D::IsFull() const {
+	return config.fixedCapacity && config.maxBodies > 0 && bodyList.size() >= config.maxBodies;
+}
+
+int Engine2D::SpawnBodies(Span<BodyDesc> descs, BodyHandle* handles, BodyError* errors) {
+	// Room for the whole batch up front, growing at least geometrically so many small
+	// batches don't reallocate every time
+	int needed = bodyList.size() + descs.size();
+	if (needed > (int)bodyList.capacity() && !config.fixedCapacity) {
+		ReserveBodies(std::max(needed, 2 * (int)bodyList.capacity()));
+	}
+
+	int added = 0;
+	for (int i = 0; i < descs.size(); ++i) {
+		const BodyDesc& desc = descs[i];
+		BodyError error = RigidBody2D::CheckBody(desc);
+
+		if (error == BodyError::None && IsFull()) {
+			error = BodyError::CapacityReached;
+			++overflow.bodies;
+		}
+		if (errors != nullptr) {
+			errors[i] = error;
+		}
+
+		if (error != BodyError::None) {
+			handles[i] = BodyHandle();
+			continue;
+		}
+		std::shared_ptr<RigidBody2D> body = RigidBody2D::Build(desc, meshes[desc.shapeType], bodyPool);
+		if (desc.shapeType == ShapeType::ConvexPolygon) {
+			body->mesh = getPolygonMesh(*body);
+		}
+		handles[i] = AddBody(body);
+		++added;
 	}
+	return added;
 }
 
+int Engine2D::SpawnBodies(const std::vector<BodyDesc>& descs, std::vector<BodyHandle>& handles, std::vector<BodyError>& errors) {
+	handles.resize(descs.size());
+	errors.resize(descs.size());
+	return SpawnBodies(Span<BodyDesc>(descs.data(), descs.size()), handles.data(), errors.data());
+}
 
-void Engine2D::AddBody(std::shared_ptr<RigidBody2D> body) {
+BodyHandle Engine2D::AddBody(std::shared_ptr<RigidBody2D> body) {
+	if (IsFull()) {
+		++overflow.bodies;
+		return BodyHandle();
+	}
+
+	body->id = nextBodyId++;
 	bodyList.push_back(body);
+	bodyStore.Add(body.get());
+	int slot = bodyList.size() - 1;
+
+	if (freeHandle == -1) {
+		HandleEntry entry;
+		entry.slot = -1;
+		entry.generation = 0;
+		handleEntries.push_back(entry);
+		freeHandle = handleEntries.size() - 1;
+	}
+	int handleIndex = freeHandle;
+	freeHandle = handleEntries[handleIndex].slot;
+	handleEntries[handleIndex].slot = slot;
+	slotToHandle.push_back(handleIndex);
+
+	AddToBroadPhase(slot);
+	return BodyHandle(handleIndex, handleEntries[handleIndex].generation);
+}
+
+bool Engine2D::RemoveBody(BodyHandle handle) {
+	return RemoveBodies(&handle, 1) == 1;
+}
+
+int Engine2D::RemoveBodies(const BodyHandle* handles, int count) {
+	// Every removal moves the last body into the hole. The broad phase structures are
+	// renamed once for the whole batch instead of once per body.
+	bool remapBroadPhase = broadPhaseType != BroadPhaseType::BruteForce;
+	if (remapBroadPhase) {
+		remapOldToNew.resize(bodyList.size());
+		remapNewToOld.resize(bodyList.size());
+		for (int i = 0; i < bodyList.size(); ++i) {
+			remapOldToNew[i] = i;
+			remapNewToOld[i] = i;
+		}
+	}
+
+	int removed = 0;
+	for (int i = 0; i < count; ++i) {
+		// Also skips handles repeated in the batch
+		if (!IsValid(handles[i])) {
+			continue;
+		}
+
+		int handleIndex = handles[i].index;
+		int slot = handleEntries[handleIndex].slot;
+		int last = bodyList.size() - 1;
+
+		if (bodyList[slot]->isStatic) {
+			staticTreeDirty = true;
+		}
+
+		if (broadPhaseType == BroadPhaseType::AABBTree) {
+			if (treeProxies[slot] != DynamicAABBTree::NULL_NODE) {
+				aabbTree.DestroyProxy(treeProxies[slot]);
+			}
+			treeProxies[slot] = treeProxies[last];
+			treeProxies.pop_back();
+			if (slot != last && treeProxies[slot] != DynamicAABBTree::NULL_NODE) {
+				aabbTree.SetUserData(treeProxies[slot], slot);
+			}
+		}
+
+		if (remapBroadPhase) {
+			remapOldToNew[remapNewToOld[slot]] = -1;
+			if (slot != last) {
+				remapOldToNew[remapNewToOld[last]] = slot;
+				remapNewToOld[slot] = remapNewToOld[last];
+			}
+		}
+
+		bodyStore.Remove(slot);
+		bodyList[slot].swap(bodyList[last]);
+		bodyList.pop_back();
+		slotToHandle[slot] = slotToHandle[last];
+		slotToHandle.pop_back();
+		if (slot != last) {
+			handleEntries[slotToHandle[slot]].slot = slot;
+		}
+
+		handleEntries[handleIndex].generation++;
+		handleEntries[handleIndex].slot = freeHandle;
+		freeHandle = handleIndex;
+		++removed;
+	}
+
+	if (removed > 0 && remapBroadPhase) {
+		RemapBroadPhase(remapOldToNew);
+	}
+	return removed;
 }
-void Engine2D::RemoveBody(int index) {
-	this->bodyList.erase(bodyList.begin() + index);
-	std::cout << "removed" << endl;
+
+bool Engine2D::IsValid(BodyHandle handle) const {
+	return handle.index < handleEntries.size() && handleEntries[handle.index].generation == handle.generation;
 }
 
+bool Engine2D::GetBody(BodyHandle handle, std::shared_ptr<RigidBody2D>& body) {
+	body = nullptr;
+	if (!IsValid(handle)) {
+		return false;
+	}
+
+	body = bodyList[handleEntries[handle.index].slot];
+	return true;
+}
 
 bool Engine2D::GetBody(int index, std::shared_ptr<RigidBody2D>& body) {
 	body = nullptr;
@@ -100,15 +376,81 @@ bool Engine2D::GetBody(int index, std::shared_ptr<RigidBody2D>& body) {
 	return true;
 }
 
-void Engine2D::ResolveCollisionsBasic(CollisionManifold contact) {
+BodyHandle Engine2D::GetBodyHandle(int index) {
+	if (index < 0 || index >= bodyList.size()) {
+		return BodyHandle();
+	}
+
+	int handleIndex = slotToHandle[index];
+	return BodyHandle(handleIndex, handleEntries[handleIndex].generation);
+}
+
+// Spreads the low 16 bits of v out to the even bits
+static unsigned int SpreadBits(unsigned int v) {
+	v &= 0x0000FFFF;
+	v = (v | (v << 8)) & 0x00FF00FF;
+	v = (v | (v << 4)) & 0x0F0F0F0F;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+void Engine2D::ReorderBodies() {
+	int count = bodyList.size();
+	if (count < 2) {
+		return;
+	}
 
-	std::shared_ptr<RigidBody2D> bodyA = contact.bodyA;
-	std::shared_ptr<RigidBody2D> bodyB = contact.bodyB;
+	const std::vector<glm::vec2>& position = bodyStore.position;
+	glm::vec2 low = position[0];
+	glm::vec2 high = low;
+	for (int i = 1; i < count; ++i) {
+		low = glm::min(low, position[i]);
+		high = glm::max(high, position[i]);
+	}
+	glm::vec2 scale = 65535.0f / glm::max(high - low, glm::vec2(1e-6f, 1e-6f));
+
+	// Sort slots along a Z curve so bodies that are close in space are close in memory
+	reorderCodes.resize(count);
+	for (int i = 0; i < count; ++i) {
+		glm::vec2 cell = (position[i] - low) * scale;
+		unsigned int code = SpreadBits(static_cast<unsigned int>(cell.x)) | (SpreadBits(static_cast<unsigned int>(cell.y)) << 1);
+		reorderCodes[i] = std::make_pair(code, i);
+	}
+	std::sort(reorderCodes.begin(), reorderCodes.end());
+
+	remapOldToNew.resize(count);
+	remapNewToOld.resize(count);
+	for (int newSlot = 0; newSlot < count; ++newSlot) {
+		int oldSlot = reorderCodes[newSlot].second;
+		remapOldToNew[oldSlot] = newSlot;
+		remapNewToOld[newSlot] = oldSlot;
+		handleEntries[slotToHandle[oldSlot]].slot = newSlot;
+	}
+	PermuteInPlace(bodyList, remapNewToOld, reorderVisited);
+	PermuteInPlace(slotToHandle, remapNewToOld, reorderVisited);
+	PermuteInPlace(treeProxies, remapNewToOld, reorderVisited);
+	bodyStore.Permute(remapNewToOld);
+
+	for (int i = 0; i < treeProxies.size(); ++i) {
+		if (treeProxies[i] != DynamicAABBTree::NULL_NODE) {
+			aabbTree.SetUserData(treeProxies[i], i);
+		}
+	}
+	RemapBroadPhase(remapOldToNew);
+
+	stepsSinceReorder = 0;
+}
+
+void Engine2D::ResolveCollisionsBasic(const CollisionManifold& contact) {
+
+	RigidBody2D& bodyA = *bodyList[contact.bodyA];
+	RigidBody2D& bodyB = *bodyList[contact.bodyB];
 	glm::vec2 normal = contact.normal;
 	float depth = contact.depth;
 
-	glm::vec2 linVelocityA = bodyA->getLinearVelocity();
-	glm::vec2 linVelocityB = bodyB->getLinearVelocity();
+	glm::vec2 linVelocityA = bodyA.getLinearVelocity();
+	glm::vec2 linVelocityB = bodyB.getLinearVelocity();
 
 	glm::vec2 relativeVelocity = linVelocityB - linVelocityA;
 
@@ -116,36 +458,36 @@ void Engine2D::ResolveCollisionsBasic(CollisionManifold contact) {
 		return;
 	}
 
-	float e = std::min(bodyA->restitution, bodyB->restitution);
+	float e = std::min(bodyA.restitution, bodyB.restitution);
 
 
 	float j = -(1.0f + e) * glm::dot(relativeVelocity, normal);
-	j /= bodyA->invMass + bodyB->invMass;
+	j /= bodyA.getInvMass() + bodyB.getInvMass();
 
 	glm::vec2 impulse = j * normal;
 
-	bodyA->setLinearVelocity(linVelocityA - (impulse * bodyA->invMass));
-	bodyB->setLinearVelocity(linVelocityB + (impulse * bodyB->invMass));
+	bodyA.setLinearVelocity(linVelocityA - (impulse * bodyA.getInvMass()));
+	bodyB.setLinearVelocity(linVelocityB + (impulse * bodyB.getInvMass()));
 }
 
-void Engine2D::ResolveCollisionsWithRotation(CollisionManifold contact) {
-	std::shared_ptr<RigidBody2D> bodyA = contact.bodyA;
-	std::shared_ptr<RigidBody2D> bodyB = contact.bodyB;
+void Engine2D::ResolveCollisionsWithRotation(const CollisionManifold& contact) {
+	RigidBody2D& bodyA = *bodyList[contact.bodyA];
+	RigidBody2D& bodyB = *bodyList[contact.bodyB];
 	glm::vec2 normal = contact.normal;
 	glm::vec2 contact1 = contact.contactOne;
 	glm::vec2 contact2 = contact.contactTwo;
 	int contactCount = contact.contactCount;
 
-	float e = std::min(bodyA->restitution, bodyB->restitution);
+	float e = std::min(bodyA.restitution, bodyB.restitution);
 
 	glm::vec2 contactList[] = { contact1, contact2 };
-	glm::vec2 impulseList[2];
+	glm::vec2 impulseList[2] = { glm::vec2(0.0f), glm::vec2(0.0f) };
 	glm::vec2 raList[2];
 	glm::vec2 rbList[2];
 
 	for (int i = 0; i < contactCount; ++i) {
-		glm::vec2 ra = contactList[i] - bodyA->getPosition();
-		glm::vec2 rb = contactList[i] - bodyB->getPosition();
+		glm::vec2 ra = contactList[i] - bodyA.getPosition();
+		glm::vec2 rb = contactList[i] - bodyB.getPosition();
 
 		raList[i] = ra;
 		rbList[i] = rb;
@@ -153,11 +495,11 @@ void Engine2D::ResolveCollisionsWithRotation(CollisionManifold contact) {
 		glm::vec2 raPerp = glm::vec2(-ra.y, ra.x);
 		glm::vec2 rbPerp = glm::vec2(-rb.y, rb.x);
 
-		glm::vec2 angularLinearVelocityA = raPerp * bodyA->getAngularVelocity();
-		glm::vec2 angularLinearVelocityB = rbPerp * bodyB->getAngularVelocity();
+		glm::vec2 angularLinearVelocityA = raPerp * bodyA.getAngularVelocity();
+		glm::vec2 angularLinearVelocityB = rbPerp * bodyB.getAngularVelocity();
 
-		glm::vec2 relativeVelocity = (bodyB->getLinearVelocity() + angularLinearVelocityB)
-									- (bodyA->getLinearVelocity() + angularLinearVelocityA);
+		glm::vec2 relativeVelocity = (bodyB.getLinearVelocity() + angularLinearVelocityB)
+									- (bodyA.getLinearVelocity() + angularLinearVelocityA);
 
 		float contactVelocityMag = glm::dot(relativeVelocity, normal);
 
@@ -168,8 +510,8 @@ void Engine2D::ResolveCollisionsWithRotation(CollisionManifold contact) {
 		float raPerpDotN = glm::dot(raPerp, normal);
 		float rbPerpDotN = glm::dot(rbPerp, normal);
 
-		float denom = bodyA->invMass + bodyB->invMass + (raPerpDotN * raPerpDotN) * bodyA->invInertia +
-														(rbPerpDotN * rbPerpDotN) * bodyB->invInertia;
+		float denom = bodyA.getInvMass() + bodyB.getInvMass() + (raPerpDotN * raPerpDotN) * bodyA.getInvInertia() +
+														(rbPerpDotN * rbPerpDotN) * bodyB.getInvInertia();
 
 		float j = -(1.0f + e) * contactVelocityMag;
 		j /= denom;
@@ -187,42 +529,56 @@ void Engine2D::ResolveCollisionsWithRotation(CollisionManifold contact) {
 		glm::vec2 ra = raList[i];
 		glm::vec2 rb = rbList[i];
 
-		bodyA->setLinearVelocity(bodyA->getLinearVelocity() - impulse * bodyA->invMass);
-		bodyB->setLinearVelocity(bodyB->getLinearVelocity() + impulse * bodyB->invMass);
+		bodyA.setLinearVelocity(bodyA.getLinearVelocity() - impulse * bodyA.getInvMass());
+		bodyB.setLinearVelocity(bodyB.getLinearVelocity() + impulse * bodyB.getInvMass());
 
 		float angularImpulseA = glm::cross(glm::vec3(ra, 0.0f), glm::vec3(impulse, 0.0f)).z;
 		float angularImpulseB = glm::cross(glm::vec3(rb, 0.0f), glm::vec3(impulse, 0.0f)).z;
 
-		bodyA->setAngularVelocity(bodyA->getAngularVelocity() - angularImpulseA * bodyA->invInertia);
-		bodyB->setAngularVelocity(bodyB->getAngularVelocity() + angularImpulseB * bodyB->invInertia);
+		bodyA.setAngularVelocity(bodyA.getAngularVelocity() - angularImpulseA * bodyA.getInvInertia());
+		bodyB.setAngularVelocity(bodyB.getAngularVelocity() + angularImpulseB * bodyB.getInvInertia());
 
 	}
 }
 
-void Engine2D::ResolveCollisionsWithRotationAndFriction(CollisionManifold contact) {
-	std::shared_ptr<RigidBody2D> bodyA = contact.bodyA;
-	std::shared_ptr<RigidBody2D> bodyB = contact.bodyB;
+void Engine2D::ResolveCollisionsWithRotationAndFriction(const CollisionManifold& contact) {
+	int slotA = contact.bodyA;
+	int slotB = contact.bodyB;
+	const RigidBody2D& bodyA = *bodyList[slotA];
+	const RigidBody2D& bodyB = *bodyList[slotB];
 	glm::vec2 normal = contact.normal;
 	glm::vec2 contact1 = contact.contactOne;
 	glm::vec2 contact2 = contact.contactTwo;
 	int contactCount = contact.contactCount;
 
-	float e = std::min(bodyA->restitution, bodyB->restitution);
+	float e = std::min(bodyA.restitution, bodyB.restitution);
+
+	float sf = (bodyA.staticFriction + bodyB.staticFriction) * 0.5f;
+	float df = (bodyA.dynamicFriction + bodyB.dynamicFriction) * 0.5f;
 
-	float sf = (bodyA->staticFriction + bodyB->staticFriction) * 0.5f;
-	float df = (bodyA->dynamicFriction + bodyB->dynamicFriction) * 0.5f;
 
+	// Hot state comes straight from the body store
+	glm::vec2 positionA = bodyStore.position[slotA];
+	glm::vec2 positionB = bodyStore.position[slotB];
+	glm::vec2& velocityA = bodyStore.linearVelocity[slotA];
+	glm::vec2& velocityB = bodyStore.linearVelocity[slotB];
+	float& angularVelocityA = bodyStore.angularVelocity[slotA];
+	float& angularVelocityB = bodyStore.angularVelocity[slotB];
+	float invMassA = bodyStore.invMass[slotA];
+	float invMassB = bodyStore.invMass[slotB];
+	float invInertiaA = bodyStore.invInertia[slotA];
+	float invInertiaB = bodyStore.invInertia[slotB];
 
 	glm::vec2 contactList[] = { contact1, contact2 };
-	glm::vec2 impulseList[2];
-	glm::vec2 frictionImpulseList[2];
+	glm::vec2 impulseList[2] = { glm::vec2(0.0f), glm::vec2(0.0f) };
+	glm::vec2 frictionImpulseList[2] = { glm::vec2(0.0f), glm::vec2(0.0f) };
 	glm::vec2 raList[2];
 	glm::vec2 rbList[2];
 	float jList[2] = { 0.0f ,0.0f };
 
 	for (int i = 0; i < contactCount; ++i) {
-		glm::vec2 ra = contactList[i] - bodyA->getPosition();
-		glm::vec2 rb = contactList[i] - bodyB->getPosition();
+		glm::vec2 ra = contactList[i] - positionA;
+		glm::vec2 rb = contactList[i] - positionB;
 
 		raList[i] = ra;
 		rbList[i] = rb;
@@ -230,11 +586,11 @@ void Engine2D::ResolveCollisionsWithRotationAndFriction(CollisionManifold contac
 		glm::vec2 raPerp = glm::vec2(-ra.y, ra.x);
 		glm::vec2 rbPerp = glm::vec2(-rb.y, rb.x);
 
-		glm::vec2 angularLinearVelocityA = raPerp * bodyA->getAngularVelocity();
-		glm::vec2 angularLinearVelocityB = rbPerp * bodyB->getAngularVelocity();
+		glm::vec2 angularLinearVelocityA = raPerp * angularVelocityA;
+		glm::vec2 angularLinearVelocityB = rbPerp * angularVelocityB;
 
-		glm::vec2 relativeVelocity = (bodyB->getLinearVelocity() + angularLinearVelocityB)
-			- (bodyA->getLinearVelocity() + angularLinearVelocityA);
+		glm::vec2 relativeVelocity = (velocityB + angularLinearVelocityB)
+			- (velocityA + angularLinearVelocityA);
 
 		float contactVelocityMag = glm::dot(relativeVelocity, normal);
 
@@ -246,8 +602,8 @@ void Engine2D::ResolveCollisionsWithRotationAndFriction(CollisionManifold contac
 		float rbPerpDotN = glm::dot(rbPerp, normal);
 
 		float j = -(1.0f + e) * contactVelocityMag;
-		float denom = bodyA->invMass + bodyB->invMass + ((raPerpDotN * raPerpDotN) * bodyA->invInertia) +
-			((rbPerpDotN * rbPerpDotN) * bodyB->invInertia);
+		float denom = invMassA + invMassB + ((raPerpDotN * raPerpDotN) * invInertiaA) +
+			((rbPerpDotN * rbPerpDotN) * invInertiaB);
 
 		j /= denom;
 		if (contactCount != 1) {
@@ -266,14 +622,14 @@ void Engine2D::ResolveCollisionsWithRotationAndFriction(CollisionManifold contac
 		glm::vec2 ra = raList[i];
 		glm::vec2 rb = rbList[i];
 
-		bodyA->setLinearVelocity(bodyA->getLinearVelocity() - impulse * bodyA->invMass);
-		bodyB->setLinearVelocity(bodyB->getLinearVelocity() + impulse * bodyB->invMass);
+		velocityA -= impulse * invMassA;
+		velocityB += impulse * invMassB;
 
 		float angularImpulseA = glm::cross(glm::vec3(ra, 0.0f), glm::vec3(impulse, 0.0f)).z;
 		float angularImpulseB = glm::cross(glm::vec3(rb, 0.0f), glm::vec3(impulse, 0.0f)).z;
 
-		bodyA->setAngularVelocity(bodyA->getAngularVelocity() - angularImpulseA * bodyA->invInertia);
-		bodyB->setAngularVelocity(bodyB->getAngularVelocity() + angularImpulseB * bodyB->invInertia);
+		angularVelocityA -= angularImpulseA * invInertiaA;
+		angularVelocityB += angularImpulseB * invInertiaB;
 
 	}
 	for (int i = 0; i < contactCount; ++i) {
@@ -283,11 +639,11 @@ void Engine2D::ResolveCollisionsWithRotationAndFriction(CollisionManifold contac
 		glm::vec2 raPerp = glm::vec2(-ra.y, ra.x);
 		glm::vec2 rbPerp = glm::vec2(-rb.y, rb.x);
 
-		glm::vec2 angularLinearVelocityA = raPerp * bodyA->getAngularVelocity();
-		glm::vec2 angularLinearVelocityB = rbPerp * bodyB->getAngularVelocity();
+		glm::vec2 angularLinearVelocityA = raPerp * angularVelocityA;
+		glm::vec2 angularLinearVelocityB = rbPerp * angularVelocityB;
 
-		glm::vec2 relativeVelocity = (bodyB->getLinearVelocity() + angularLinearVelocityB)
-			- (bodyA->getLinearVelocity() + angularLinearVelocityA);
+		glm::vec2 relativeVelocity = (velocityB + angularLinearVelocityB)
+			- (velocityA + angularLinearVelocityA);
 
 		glm::vec2 tangent = relativeVelocity - glm::dot(relativeVelocity, normal) * normal;
 
@@ -301,8 +657,8 @@ void Engine2D::ResolveCollisionsWithRotationAndFriction(CollisionManifold contac
 		float raPerpDotT = glm::dot(raPerp, tangent);
 		float rbPerpDotT = glm::dot(rbPerp, tangent);
 
-		float denom = bodyA->invMass + bodyB->invMass + (raPerpDotT * raPerpDotT) * bodyA->invInertia +
-			(rbPerpDotT * rbPerpDotT) * bodyB->invInertia;
+		float denom = invMassA + invMassB + (raPerpDotT * raPerpDotT) * invInertiaA +
+			(rbPerpDotT * rbPerpDotT) * invInertiaB;
 		if (denom < 1e-6f) {
 			denom = 1e-6f;
 		}
@@ -336,89 +692,502 @@ void Engine2D::ResolveCollisionsWithRotationAndFriction(CollisionManifold contac
 		glm::vec2 ra = raList[i];
 		glm::vec2 rb = rbList[i];
 
-		bodyA->setLinearVelocity(bodyA->getLinearVelocity() - impulse * bodyA->invMass);
-		bodyB->setLinearVelocity(bodyB->getLinearVelocity() + impulse * bodyB->invMass);
+		velocityA -= impulse * invMassA;
+		velocityB += impulse * invMassB;
 
 		float angularImpulseA = ra.x * impulse.y - ra.y * impulse.x;
 		float angularImpulseB = rb.x * impulse.y - rb.y * impulse.x;
 
-		bodyA->setAngularVelocity(bodyA->getAngularVelocity() - angularImpulseA * bodyA->invInertia);
-		bodyB->setAngularVelocity(bodyB->getAngularVelocity() + angularImpulseB * bodyB->invInertia);
+		angularVelocityA -= angularImpulseA * invInertiaA;
+		angularVelocityB += angularImpulseB * invInertiaB;
 
 	}
 }
 
 
 void Engine2D::Step(float time, int iterations) {
-	for (int i = 0; i < iterations; ++i) {
-		contactPairs.clear();
+	contactPairs = nullptr;
+	contactPairCount = 0;
+	manifolds = nullptr;
+	manifoldCount = 0;
+	manifoldCapacity = 0;
+	killedBodies.clear();
+	findKilledBodies = killBoundsEnabled;
+
+	if (reorderInterval > 0 && ++stepsSinceReorder >= reorderInterval) {
+		ReorderBodies();
+	}
+
+	if (!broadPhaseOncePerStep) {
+		for (int i = 0; i < iterations; ++i) {
+			StepBodies(time, iterations);
+			BroadPhase();
+			NarrowPhase();
+		}
+		RemoveKilledBodies();
+		return;
+	}
+
+	// Pairs are found once from bounds that cover each body's motion over the whole step
+	UpdateSweptBounds(time);
+	FindPairs();
 
+	for (int i = 0; i < iterations; ++i) {
 		StepBodies(time, iterations);
-		BroadPhase();
+
+		// A collision can push a body further than predicted, search again for the rest of the step
+		if (!BodiesInsideBounds()) {
+			UpdateSweptBounds(time * (iterations - i - 1) / iterations);
+			FindPairs();
+		}
+
 		NarrowPhase();
 	}
+	RemoveKilledBodies();
+}
+
+void Engine2D::SetKillBounds(const AABB& bounds) {
+	killBounds = bounds;
+	killBoundsEnabled = true;
+}
+
+void Engine2D::CheckKillBounds(int index) {
+	if (!Collisions::OverlapAABBs(killBounds, bodyList[index]->getAABB())) {
+		killedBodies.push_back(GetBodyHandle(index));
+	}
+}
+
+void Engine2D::RemoveKilledBodies() {
+	if (!killedBodies.empty()) {
+		RemoveBodies(killedBodies);
+	}
+}
+
+void Engine2D::SetBroadPhaseType(BroadPhaseType type) {
+	if (type == broadPhaseType) {
+		return;
+	}
+	broadPhaseType = type;
+
+	sweepAndPrune.Clear();
+	aabbTree.Clear();
+	treeProxies.clear();
+	spatialHash.Clear();
+	hierarchicalGrid.Clear();
+	ReserveBroadPhase(bodyList.capacity());
+	for (int i = 0; i < bodyList.size(); ++i) {
+		AddToBroadPhase(i);
+	}
+	staticTreeDirty = true;
+}
+
+void Engine2D::AddToBroadPhase(int index) {
+	// Static bodies only go into the static tree, which is rebuilt on the next pass
+	if (bodyList[index]->isStatic) {
+		staticTreeDirty = true;
+		if (broadPhaseType == BroadPhaseType::AABBTree) {
+			treeProxies.push_back(DynamicAABBTree::NULL_NODE);
+		}
+		return;
+	}
+
+	switch (broadPhaseType) {
+	case BroadPhaseType::SweepAndPrune:
+		sweepAndPrune.AddBody(index);
+		break;
+	case BroadPhaseType::AABBTree:
+		treeProxies.push_back(aabbTree.CreateProxy(bodyList[index]->getAABB(), index));
+		break;
+	case BroadPhaseType::SpatialHash:
+		spatialHash.AddBody(index);
+		break;
+	case BroadPhaseType::HierarchicalGrid:
+		hierarchicalGrid.AddBody(index);
+		break;
+	default:
+		break;
+	}
+}
+
+// Broad phase structures keep body indices, oldToNew gives each body's new index or -1
+// if it was removed
+void Engine2D::RemapBroadPhase(const std::vector<int>& oldToNew) {
+	switch (broadPhaseType) {
+	case BroadPhaseType::SweepAndPrune:
+		sweepAndPrune.Remap(oldToNew);
+		break;
+	case BroadPhaseType::SpatialHash:
+		spatialHash.Remap(oldToNew);
+		break;
+	case BroadPhaseType::HierarchicalGrid:
+		hierarchicalGrid.Remap(oldToNew);
+		break;
+	default:
+		break;
+	}
+
+	// A dirty tree may hold bodies that are gone, it's rebuilt before it's used again anyway
+	if (staticTreeDirty) {
+		staticTree.Clear();
+	}
+	else {
+		staticTree.Remap(oldToNew);
+	}
+}
+
+void Engine2D::BuildStaticTree() {
+	staticTree.Clear();
+	for (int i = 0; i < bodyList.size(); ++i) {
+		if (bodyList[i]->isStatic) {
+			staticTree.Add(i, bodyList[i]->getAABB());
+		}
+	}
+	staticTree.Build();
+	staticTreeDirty = false;
 }
 
 void Engine2D::BroadPhase() {
+	UpdateBodyBounds();
+	FindPairs();
+}
+
+void Engine2D::UpdateBodyBounds() {
+	// Static bounds are only needed by the brute force search, the other broad phases
+	// keep them in the static tree
+	bool includeStatic = broadPhaseType == BroadPhaseType::BruteForce;
+
+	bodyAABBs.resize(bodyList.size());
 	for (int i = 0; i < bodyList.size(); ++i) {
-		std::shared_ptr<RigidBody2D> bodyA = bodyList[i];
-		AABB bodyAAabb = bodyA->getAABB();
+		if (findKilledBodies) {
+			CheckKillBounds(i);
+		}
+		if (includeStatic || !bodyList[i]->isStatic) {
+			bodyAABBs[i] = bodyList[i]->getAABB();
+		}
+	}
+	findKilledBodies = false;
+}
+
+void Engine2D::UpdateSweptBounds(float time) {
+	bool includeStatic = broadPhaseType == BroadPhaseType::BruteForce;
+	float gravityTime = 0.5f * time * time;
+
+	bodyAABBs.resize(bodyList.size());
+	for (int i = 0; i < bodyList.size(); ++i) {
+		std::shared_ptr<RigidBody2D>& body = bodyList[i];
+		if (findKilledBodies) {
+			CheckKillBounds(i);
+		}
+		if (body->isStatic) {
+			if (includeStatic) {
+				bodyAABBs[i] = body->getAABB();
+			}
+			continue;
+		}
+
+		AABB box = body->getAABB();
+
+		// A spinning body can reach anywhere within its bounding circle
+		if (bodyStore.angularVelocity[i] != 0.0f) {
+			float radius = body->getBoundingRadius();
+			box = AABB(bodyStore.position[i] - glm::vec2(radius, radius), bodyStore.position[i] + glm::vec2(radius, radius));
+		}
+
+		glm::vec2 displacement = bodyStore.linearVelocity[i] * time + gravity * gravityTime;
+		AABB movedBox = AABB(box.min + displacement, box.max + displacement);
+
+		bodyAABBs[i] = AABB::Combine(box, movedBox).Expanded(SWEPT_AABB_MARGIN);
+	}
+	findKilledBodies = false;
+}
+
+bool Engine2D::BodiesInsideBounds() {
+	for (int i = 0; i < bodyList.size(); ++i) {
+		if (!bodyList[i]->isStatic && !bodyAABBs[i].Contains(bodyList[i]->getAABB())) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Engine2D::FindPairs() {
+	if (broadPhaseType != BroadPhaseType::BruteForce && staticTreeDirty) {
+		BuildStaticTree();
+	}
+
+	// Structure updates stay on this thread, only the pair queries are split up
+	int itemCount = 0;
+	switch (broadPhaseType) {
+	case BroadPhaseType::BruteForce:
+		itemCount = bodyList.size();
+		break;
+	case BroadPhaseType::SweepAndPrune:
+		sweepAndPrune.Update(bodyAABBs);
+		itemCount = sweepAndPrune.GetBodyCount();
+		break;
+	case BroadPhaseType::AABBTree:
+		// Most bodies are still inside their fat AABB and cost nothing here
+		for (int i = 0; i < bodyList.size(); ++i) {
+			if (treeProxies[i] != DynamicAABBTree::NULL_NODE) {
+				aabbTree.MoveProxy(treeProxies[i], bodyAABBs[i]);
+			}
+		}
+		itemCount = bodyList.size();
+		break;
+	case BroadPhaseType::SpatialHash:
+		spatialHash.Update(bodyAABBs);
+		overflow.cells += spatialHash.GetDroppedCount();
+		itemCount = spatialHash.GetBucketCount();
+		break;
+	case BroadPhaseType::HierarchicalGrid:
+		hierarchicalGrid.Update(bodyAABBs);
+		itemCount = hierarchicalGrid.GetBodyCount();
+		break;
+	default:
+		break;
+	}
+
+	// Only changes size when the thread count changes
+	if (pairBuffers.size() != threadPool.GetThreadCount() + 1) {
+		pairBuffers.resize(threadPool.GetThreadCount() + 1);
+		if (config.maxPairs > 0) {
+			for (int i = 0; i < pairBuffers.size(); ++i) {
+				pairBuffers[i].Reserve(config.maxPairs, config.fixedCapacity);
+			}
+		}
+	}
+	for (int i = 0; i < pairBuffers.size(); ++i) {
+		pairBuffers[i].clear();
+	}
+
+	// The structures only read during the search, so each range can run on its own thread
+	// with its own pair buffer
+	threadPool.ParallelFor(itemCount, [this](int thread, int begin, int end) {
+		FindPairsInRange(begin, end, pairBuffers[thread]);
+	});
+
+	// Static bodies are only in the static tree, moving bodies query it separately
+	if (broadPhaseType != BroadPhaseType::BruteForce && !staticTree.IsEmpty()) {
+		threadPool.ParallelFor(bodyList.size(), [this](int thread, int begin, int end) {
+			FindStaticPairsInRange(begin, end, pairBuffers[thread]);
+		});
+	}
+
+	// The arena only holds the results of one search, everything from the last one goes at once
+	frameArena.Reset();
+	contactPairCount = 0;
+	for (int i = 0; i < pairBuffers.size(); ++i) {
+		contactPairCount += pairBuffers[i].size();
+		overflow.pairs += pairBuffers[i].GetDroppedCount();
+	}
+
+	// With a fixed capacity the pairs past the limit are dropped, which ones depends on
+	// how the search was split between threads
+	if (config.fixedCapacity && config.maxPairs > 0 && contactPairCount > config.maxPairs) {
+		overflow.pairs += contactPairCount - config.maxPairs;
+		contactPairCount = config.maxPairs;
+	}
+	manifoldCapacity = contactPairCount;
+	if (config.fixedCapacity && config.maxContacts > 0) {
+		manifoldCapacity = std::min(manifoldCapacity, config.maxContacts);
+	}
+
+	contactPairs = frameArena.Allocate<ContactPair>(contactPairCount);
+	manifolds = frameArena.Allocate<CollisionManifold>(manifoldCapacity);
+	manifoldCount = 0;
+
+	ContactPair* write = contactPairs;
+	int remaining = contactPairCount;
+	for (int i = 0; i < pairBuffers.size(); ++i) {
+		int count = std::min(pairBuffers[i].size(), remaining);
+		write = std::uninitialized_copy(pairBuffers[i].begin(), pairBuffers[i].begin() + count, write);
+		remaining -= count;
+	}
+
+	// Sorted so the result doesn't depend on the thread count and the narrow phase
+	// resolves pairs in the same order as the brute force search
+	std::sort(contactPairs, contactPairs + contactPairCount);
+
+	UpdatePairCache();
+}
+
+void Engine2D::FindPairsInRange(int begin, int end, PairBuffer& pairs) {
+	switch (broadPhaseType) {
+	case BroadPhaseType::BruteForce:
+		BroadPhaseBruteForce(begin, end, pairs);
+		break;
+	case BroadPhaseType::SweepAndPrune:
+		sweepAndPrune.FindPairs(begin, end, pairs);
+		break;
+	case BroadPhaseType::AABBTree:
+		BroadPhaseTree(begin, end, pairs);
+		break;
+	case BroadPhaseType::SpatialHash:
+		spatialHash.FindPairs(begin, end, pairs);
+		break;
+	case BroadPhaseType::HierarchicalGrid:
+		hierarchicalGrid.FindPairs(begin, end, pairs);
+		break;
+	default:
+		break;
+	}
+}
+
+void Engine2D::FindStaticPairsInRange(int begin, int end, PairBuffer& pairs) {
+	for (int i = begin; i < end; ++i) {
+		if (bodyList[i]->isStatic) {
+			continue;
+		}
+
+		auto callback = [&](int j) {
+			if (i < j) {
+				pairs.push_back(ContactPair(i, j));
+			}
+			else {
+				pairs.push_back(ContactPair(j, i));
+			}
+		};
+		staticTree.Query(bodyAABBs[i], callback);
+	}
+}
+
+void Engine2D::UpdatePairCache() {
+	pairCache.BeginUpdate();
+	for (int i = 0; i < contactPairCount; ++i) {
+		contactPairs[i].cacheIndex = pairCache.AddPair(bodyList[contactPairs[i].item1]->getId(), bodyList[contactPairs[i].item2]->getId());
+	}
+	pairCache.EndUpdate();
+}
+
+void Engine2D::BroadPhaseTree(int begin, int end, PairBuffer& pairs) {
+	for (int i = begin; i < end; ++i) {
+		if (treeProxies[i] == DynamicAABBTree::NULL_NODE) {
+			continue;
+		}
+		const AABB& box = bodyAABBs[i];
+
+		auto callback = [&](int proxyId) {
+			int j = aabbTree.GetUserData(proxyId);
+			// Each pair is found from both bodies, only keep it once
+			if (j <= i) {
+				return true;
+			}
+			if (!Collisions::OverlapAABBs(box, bodyAABBs[j])) {
+				return true;
+			}
+			pairs.push_back(ContactPair(i, j));
+			return true;
+		};
+		aabbTree.Query(box, callback);
+	}
+}
+
+void Engine2D::BroadPhaseBruteForce(int begin, int end, PairBuffer& pairs) {
+	for (int i = begin; i < end; ++i) {
+		const std::shared_ptr<RigidBody2D>& bodyA = bodyList[i];
+		AABB bodyAAabb = bodyAABBs[i];
 
 		for (int j = i + 1; j < bodyList.size(); ++j) {
-			std::shared_ptr<RigidBody2D> bodyB = bodyList[j];
-			AABB bodyBAabb = bodyB->getAABB();
+			const std::shared_ptr<RigidBody2D>& bodyB = bodyList[j];
+			AABB bodyBAabb = bodyAABBs[j];
 
 			if (bodyA->isStatic && bodyB->isStatic) {
 				continue;
 			}
 
-			if (Collisions::IntersectAABBs(bodyAAabb, bodyBAabb)) {
+			if (!Collisions::OverlapAABBs(bodyAAabb, bodyBAabb)) {
 				continue;
 			}
 
-			contactPairs.push_back(ContactPair(i, j));
+			pairs.push_back(ContactPair(i, j));
 		}
 	}
 }
 void Engine2D::NarrowPhase() {
-	for (int i = 0; i < contactPairs.size(); ++i) {
-		glm::vec2 normal;
-		float depth;
-		std::shared_ptr<RigidBody2D> bodyA = bodyList[contactPairs[i].item1];
-		std::shared_ptr<RigidBody2D> bodyB = bodyList[contactPairs[i].item2];
+	manifoldCount = 0;
+	for (int i = 0; i < contactPairCount; ++i) {
+		CollisionManifold result;
+		int slotA = contactPairs[i].item1;
+		int slotB = contactPairs[i].item2;
+		RigidBody2D& bodyA = *bodyList[slotA];
+		RigidBody2D& bodyB = *bodyList[slotB];
+		PairCache::Pair& pair = pairCache.GetPair(contactPairs[i].cacheIndex);
+		pair.touching = false;
+
+		// Pairs can come from swept or fat bounds, skip them early if the bodies are apart now
+		if (!Collisions::OverlapAABBs(bodyA.getAABB(), bodyB.getAABB())) {
+			continue;
+		}
+
+		bool colliding;
+		if (narrowPhaseType == NarrowPhaseType::GJK) {
+			// The cached simplex is kept in the pair's id order
+			bool flipped = bodyA.getId() != pair.idA;
+			SimplexCache simplex = flipped ? pair.simplex.Flipped() : pair.simplex;
+			colliding = Collisions::CollideConvex(bodyA, bodyB, result, simplex);
+			pair.simplex = flipped ? simplex.Flipped() : simplex;
+		}
+		else {
+			colliding = Collisions::Collide(bodyA, bodyB, result);
+		}
 
+		if (colliding) {
+			// The cached normal always points from the body with the lower id
+			pair.touching = true;
+			pair.normal = bodyA.getId() == pair.idA ? result.normal : -result.normal;
+			pair.depth = result.depth;
 
-		if (Collisions::Collide(bodyA, bodyB, normal, depth)) {
-			SeperateBodies(bodyA, bodyB, (normal * depth));
+			SeperateBodies(slotA, slotB, (result.normal * result.depth));
 
-			glm::vec2 contactOne, contactTwo;
-			int contactCount = 0;
-			Collisions::FindContactPoints(bodyA, bodyB, contactOne, contactTwo, contactCount);
-			CollisionManifold contact = CollisionManifold(bodyA, bodyB, depth, normal, contactOne, contactTwo, contactCount);
-			this->ResolveCollisionsWithRotationAndFriction(contact);
+			// Past the manifold limit the contact is still resolved, it just isn't kept
+			CollisionManifold overflowContact;
+			CollisionManifold* contact = &overflowContact;
+			if (manifoldCount < manifoldCapacity) {
+				contact = &manifolds[manifoldCount++];
+			}
+			else {
+				++overflow.contacts;
+			}
+			// Contact points found before separating only moved along the normal, which
+			// doesn't change the impulse's torque
+			*contact = result;
+			contact->bodyA = slotA;
+			contact->bodyB = slotB;
+			Collisions::FindContactPoints(bodyA, bodyB, *contact);
+			this->ResolveCollisionsWithRotationAndFriction(*contact);
 		}
 
 	}
 }
 
 void Engine2D::StepBodies(float time, int iterations) {
-	for (int i = 0; i < bodyList.size(); ++i) {
-		if (!bodyList[i]->isStatic) {
-			bodyList[i]->Step(time, gravity, iterations);
+	time /= (float)iterations;
+
+	// Same integration as RigidBody2D::Step, run over the store arrays
+	glm::vec2 gravityStep = gravity * time;
+	for (int i = 0; i < bodyStore.Size(); ++i) {
+		if (bodyStore.invMass[i] == 0.0f) {
+			continue;
 		}
+		bodyStore.linearVelocity[i] += gravityStep;
+		bodyStore.position[i] += bodyStore.linearVelocity[i] * time;
+		bodyStore.angle[i] += bodyStore.angularVelocity[i] * time;
+		bodyStore.dirty[i] = BodyStore::MOVED;
 	}
 }
 
-void Engine2D::SeperateBodies(std::shared_ptr<RigidBody2D> bodyA, std::shared_ptr<RigidBody2D> bodyB, glm::vec2 mtv) {
-	if (bodyA->isStatic) {
-		bodyB->Move(mtv);
+void Engine2D::SeperateBodies(int slotA, int slotB, glm::vec2 mtv) {
+	if (bodyStore.invMass[slotA] == 0.0f) {
+		bodyStore.position[slotB] += mtv;
 	}
-	else if (bodyB->isStatic) {
-		bodyA->Move(-mtv);
+	else if (bodyStore.invMass[slotB] == 0.0f) {
+		bodyStore.position[slotA] -= mtv;
 	}
 	else {
-		bodyA->Move(-mtv / 2.0f);
-		bodyB->Move(mtv / 2.0f);
+		bodyStore.position[slotA] -= mtv / 2.0f;
+		bodyStore.position[slotB] += mtv / 2.0f;
 	}
+	bodyStore.dirty[slotA] = BodyStore::MOVED;
+	bodyStore.dirty[slotB] = BodyStore::MOVED;
 }
 
@@ -0,0 +1,60 @@
+#include "../include/frame_arena.h"
+
+#include <new>
+
+FrameArena::FrameArena(std::size_t capacity) {
+	this->capacity = capacity;
+	buffer = static_cast<char*>(::operator new(capacity));
+	offset = 0;
+	overflowSize = 0;
+}
+
+FrameArena::~FrameArena() {
+	for (int i = 0; i < overflowBlocks.size(); ++i) {
+		::operator delete(overflowBlocks[i]);
+	}
+	::operator delete(buffer);
+}
+
+void* FrameArena::AllocateBytes(std::size_t size, std::size_t alignment) {
+	std::size_t start = (offset + alignment - 1) & ~(alignment - 1);
+	if (start + size <= capacity) {
+		offset = start + size;
+		return buffer + start;
+	}
+
+	// Memory from operator new is aligned for any type the engine puts here
+	void* block = ::operator new(size);
+	overflowBlocks.push_back(block);
+	overflowSize += size;
+	return block;
+}
+
+void FrameArena::Reserve(std::size_t capacity) {
+	if (capacity <= this->capacity) {
+		return;
+	}
+	::operator delete(buffer);
+	buffer = static_cast<char*>(::operator new(capacity));
+	this->capacity = capacity;
+	offset = 0;
+}
+
+void FrameArena::Reset() {
+	if (!overflowBlocks.empty()) {
+		for (int i = 0; i < overflowBlocks.size(); ++i) {
+			::operator delete(overflowBlocks[i]);
+		}
+		overflowBlocks.clear();
+
+		// Grow so the whole of the last step fits in the buffer next time
+		std::size_t needed = offset + overflowSize;
+		while (capacity < needed) {
+			capacity *= 2;
+		}
+		::operator delete(buffer);
+		buffer = static_cast<char*>(::operator new(capacity));
+		overflowSize = 0;
+	}
+	offset = 0;
+}
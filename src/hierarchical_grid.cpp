@@ -0,0 +1,171 @@
+#include "../include/hierarchical_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+HierarchicalGrid::HierarchicalGrid(float baseCellSize) {
+	this->baseCellSize = baseCellSize;
+	occupiedLevels = 0;
+	bounds = nullptr;
+	bucketMask = 0;
+}
+
+void HierarchicalGrid::AddBody(int index) {
+	bodies.insert(std::lower_bound(bodies.begin(), bodies.end(), index), index);
+}
+
+void HierarchicalGrid::Reserve(int count) {
+	int bucketCount = 16;
+	while (bucketCount < 2 * count) {
+		bucketCount *= 2;
+	}
+
+	bodies.reserve(count);
+	bodyCells.reserve(count);
+	entries.reserve(count);
+	bucketStart.reserve(bucketCount + 1);
+	bucketFill.reserve(bucketCount);
+}
+
+void HierarchicalGrid::Remap(const std::vector<int>& oldToNew) {
+	int write = 0;
+	for (int i = 0; i < bodies.size(); ++i) {
+		int body = oldToNew[bodies[i]];
+		if (body >= 0) {
+			bodies[write++] = body;
+		}
+	}
+	bodies.resize(write);
+	std::sort(bodies.begin(), bodies.end());
+}
+
+void HierarchicalGrid::Clear() {
+	bodies.clear();
+	bodyCells.clear();
+	entries.clear();
+	bucketStart.clear();
+	bucketFill.clear();
+	occupiedLevels = 0;
+	bounds = nullptr;
+}
+
+unsigned int HierarchicalGrid::HashCell(int level, int cellX, int cellY) {
+	return static_cast<unsigned int>(cellX) * 73856093u ^ static_cast<unsigned int>(cellY) * 19349663u ^
+		static_cast<unsigned int>(level) * 83492791u;
+}
+
+int HierarchicalGrid::CellCoord(float value, float cellSize) {
+	return static_cast<int>(std::floor(value / cellSize));
+}
+
+void HierarchicalGrid::Update(const std::vector<AABB>& bounds) {
+	this->bounds = &bounds;
+
+	float size = baseCellSize;
+	for (int level = 0; level < MAX_LEVELS; ++level) {
+		cellSizes[level] = size;
+		size *= 2.0f;
+	}
+
+	occupiedLevels = 0;
+	bodyCells.resize(bodies.size());
+	for (int i = 0; i < bodies.size(); ++i) {
+		const AABB& box = bounds[bodies[i]];
+		float extent = std::max(box.max.x - box.min.x, box.max.y - box.min.y);
+
+		int level = 0;
+		while (level < MAX_LEVELS - 1 && cellSizes[level] < extent) {
+			++level;
+		}
+
+		glm::vec2 center = (box.min + box.max) * 0.5f;
+		bodyCells[i].level = level;
+		bodyCells[i].cellX = CellCoord(center.x, cellSizes[level]);
+		bodyCells[i].cellY = CellCoord(center.y, cellSizes[level]);
+		bodyCells[i].body = bodies[i];
+		occupiedLevels |= 1u << level;
+	}
+
+	// Same counting sort into hashed buckets as SpatialHashGrid, one entry per body
+	int bucketCount = 16;
+	while (bucketCount < 2 * bodyCells.size()) {
+		bucketCount *= 2;
+	}
+	bucketMask = bucketCount - 1;
+
+	bucketStart.assign(bucketCount + 1, 0);
+	for (int i = 0; i < bodyCells.size(); ++i) {
+		++bucketStart[(HashCell(bodyCells[i].level, bodyCells[i].cellX, bodyCells[i].cellY) & bucketMask) + 1];
+	}
+	for (int i = 0; i < bucketCount; ++i) {
+		bucketStart[i + 1] += bucketStart[i];
+	}
+
+	entries.resize(bodyCells.size());
+	bucketFill.assign(bucketStart.begin(), bucketStart.end() - 1);
+	for (int i = 0; i < bodyCells.size(); ++i) {
+		int bucket = HashCell(bodyCells[i].level, bodyCells[i].cellX, bodyCells[i].cellY) & bucketMask;
+		entries[bucketFill[bucket]++] = bodyCells[i];
+	}
+}
+
+void HierarchicalGrid::FindPairs(int begin, int end, PairBuffer& pairs) const {
+	if (bounds == nullptr) {
+		return;
+	}
+
+	for (int i = begin; i < end; ++i) {
+		const CellEntry& cellA = bodyCells[i];
+		int bodyA = cellA.body;
+		const AABB& boxA = (*bounds)[bodyA];
+
+		// Smaller bodies on lower levels find this one themselves
+		unsigned int levels = occupiedLevels >> cellA.level;
+		for (int level = cellA.level; levels != 0; ++level, levels >>= 1) {
+			if ((levels & 1) == 0) {
+				continue;
+			}
+
+			// Bodies on this level are at most one cell wide, so any that overlap boxA
+			// have their center within half a cell of it
+			float cellSize = cellSizes[level];
+			float reach = cellSize * 0.5f;
+			int minX = CellCoord(boxA.min.x - reach, cellSize);
+			int minY = CellCoord(boxA.min.y - reach, cellSize);
+			int maxX = CellCoord(boxA.max.x + reach, cellSize);
+			int maxY = CellCoord(boxA.max.y + reach, cellSize);
+
+			for (int y = minY; y <= maxY; ++y) {
+				for (int x = minX; x <= maxX; ++x) {
+					int bucket = HashCell(level, x, y) & bucketMask;
+
+					for (int k = bucketStart[bucket]; k < bucketStart[bucket + 1]; ++k) {
+						const CellEntry& cellB = entries[k];
+						if (cellB.level != level || cellB.cellX != x || cellB.cellY != y) {
+							continue;
+						}
+
+						int bodyB = cellB.body;
+						// Bodies on the same level find each other, only keep the pair once
+						if (level == cellA.level && bodyB <= bodyA) {
+							continue;
+						}
+
+						const AABB& boxB = (*bounds)[bodyB];
+						if (boxA.max.x <= boxB.min.x || boxB.max.x <= boxA.min.x ||
+							boxA.max.y <= boxB.min.y || boxB.max.y <= boxA.min.y) {
+							continue;
+						}
+
+						if (bodyA < bodyB) {
+							pairs.push_back(ContactPair(bodyA, bodyB));
+						}
+						else {
+							pairs.push_back(ContactPair(bodyB, bodyA));
+						}
+					}
+				}
+			}
+		}
+	}
+}
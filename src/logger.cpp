@@ -0,0 +1,166 @@
+#include "../include/logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+const int Logger::CAPACITY;
+const int Logger::MAX_ARGS;
+const int Logger::TEXT_SIZE;
+
+Logger& Logger::Get() {
+	static Logger logger;
+	return logger;
+}
+
+Logger::Logger() : cells(new Cell[CAPACITY]), writePos(0), readPos(0), dropped(0), stopping(false) {
+	for (int i = 0; i < CAPACITY; ++i) {
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	worker = std::thread(&Logger::WorkerLoop, this);
+}
+
+Logger::~Logger() {
+	stopping.store(true, std::memory_order_release);
+	worker.join();
+}
+
+Logger::Arg& Logger::Record::Next(ArgType type) {
+	Arg& arg = args[argCount];
+	if (argCount < MAX_ARGS) {
+		++argCount;
+	}
+	arg.type = type;
+	return arg;
+}
+
+void Logger::Record::AddText(const char* value, std::size_t length) {
+	Arg& arg = Next(ArgType::Text);
+
+	// Long strings are cut to what's left of the text buffer, once it's full they print
+	// as the empty string at its end
+	if (textUsed >= TEXT_SIZE) {
+		arg.textOffset = TEXT_SIZE - 1;
+		return;
+	}
+	std::size_t room = TEXT_SIZE - textUsed - 1;
+	if (length > room) {
+		length = room;
+	}
+	std::memcpy(text + textUsed, value, length);
+	text[textUsed + length] = '\0';
+	arg.textOffset = textUsed;
+	textUsed += length + 1;
+}
+
+bool Logger::Push(const Record& record) {
+	std::size_t pos = writePos.load(std::memory_order_relaxed);
+	Cell* cell;
+	while (true) {
+		cell = &cells[pos & (CAPACITY - 1)];
+		std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)pos;
+		if (diff == 0) {
+			// The slot is free, claim it unless another thread got there first
+			if (writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		}
+		else if (diff < 0) {
+			// The reader hasn't freed this slot yet, the buffer is full
+			return false;
+		}
+		else {
+			pos = writePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->record = record;
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool Logger::Pop(Record& record) {
+	Cell& cell = cells[readPos & (CAPACITY - 1)];
+	std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+	if (sequence != readPos + 1) {
+		return false;
+	}
+
+	record = cell.record;
+	cell.sequence.store(readPos + CAPACITY, std::memory_order_release);
+	++readPos;
+	return true;
+}
+
+void Logger::WorkerLoop() {
+	std::string line;
+	line.reserve(256);
+
+	while (!stopping.load(std::memory_order_acquire)) {
+		if (!Drain(line)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+	}
+	// Whatever was written before shutdown still gets printed
+	Drain(line);
+}
+
+bool Logger::Drain(std::string& line) {
+	bool any = false;
+	Record record;
+	while (Pop(record)) {
+		Format(record, line);
+		std::fwrite(line.data(), 1, line.size(), record.level >= LogLevel::Warning ? stderr : stdout);
+		any = true;
+	}
+
+	int lost = dropped.exchange(0, std::memory_order_relaxed);
+	if (lost > 0) {
+		std::fprintf(stderr, "[log] %d messages dropped, the buffer was full\n", lost);
+		any = true;
+	}
+
+	if (any) {
+		std::fflush(stdout);
+		std::fflush(stderr);
+	}
+	return any;
+}
+
+void Logger::Format(const Record& record, std::string& line) {
+	static const char* LEVEL_NAMES[] = { "[debug] ", "[info] ", "[warning] ", "[error] " };
+
+	line.clear();
+	line += LEVEL_NAMES[(int)record.level];
+
+	char number[32];
+	int nextArg = 0;
+	for (const char* c = record.format; *c != '\0'; ++c) {
+		if (c[0] != '{' || c[1] != '}' || nextArg >= record.argCount) {
+			line += *c;
+			continue;
+		}
+
+		const Arg& arg = record.args[nextArg++];
+		switch (arg.type) {
+		case ArgType::Int:
+			std::snprintf(number, sizeof(number), "%lld", (long long)arg.i);
+			line += number;
+			break;
+		case ArgType::UInt:
+			std::snprintf(number, sizeof(number), "%llu", (unsigned long long)arg.u);
+			line += number;
+			break;
+		case ArgType::Float:
+			std::snprintf(number, sizeof(number), "%g", arg.f);
+			line += number;
+			break;
+		case ArgType::Text:
+			line += record.text + arg.textOffset;
+			break;
+		}
+		++c;
+	}
+	line += '\n';
+}
@@ -17,6 +17,8 @@
 #include "../include/collisions.h"
 #include "../include/engine_2D.h"
 #include "../include/aabb.h"
+#include "../include/logger.h"
+#include "../include/allocation_check.h"
 
 #define _USE_MATH_DEFINES
 
@@ -36,30 +38,6 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
-void CullScreen(Engine2D& engine) {
-    float lowX = -RES_WIDTH / (2 * SCALE_FACTOR);
-    float highX = RES_WIDTH / (2 * SCALE_FACTOR);
-    float lowY = -RES_HEIGHT / (2 * SCALE_FACTOR);
-    float highY = RES_HEIGHT / (2 * SCALE_FACTOR);
-
-    std::vector<int> removeQueue;  
-
-    for (int i = 0; i < engine.GetBodyCount(); ++i) {
-        std::shared_ptr<RigidBody2D> body;
-        engine.GetBody(i, body);
-        AABB box = body->getAABB();
-
-        if (box.max.x < lowX || box.min.x > highX || box.max.y < lowY || box.min.y > highY) {
-            removeQueue.push_back(i);
-            std::cout << body->getPosition().x << ", " << body->getPosition().y << endl;
-        }
-
-    }
-    for (int i = removeQueue.size() - 1; i >= 0; --i) {
-        engine.RemoveBody(removeQueue[i]);
-    }
-}
-
 // Checks for keyboard presses
 void processInput(GLFWwindow* window, Engine2D& engine) {
 
@@ -91,7 +69,7 @@ void processInput(GLFWwindow* window, Engine2D& engine) {
 
             worldCoord /= worldCoord.w;
 
-            std::cout << "coordinates are" << worldCoord.x << ", " << worldCoord.y << "\n";
+            LOG_DEBUG("coordinates are {}, {}", worldCoord.x, worldCoord.y);
 
             std::shared_ptr<RigidBody2D> body;
 
@@ -99,13 +77,13 @@ void processInput(GLFWwindow* window, Engine2D& engine) {
             std::mt19937 gen(rd());
             std::uniform_real_distribution<float> dist(10.0f, 30.0f);
 
-            bool success = RigidBody2D::CreateSquareBody(dist(gen), dist(gen), glm::vec2(worldCoord.x, worldCoord.y), 0.5f, false, 0.5f, body, errorMessage, engine.getSquareMesh());
+            bool success = engine.CreateSquareBody(dist(gen), dist(gen), glm::vec2(worldCoord.x, worldCoord.y), 0.5f, false, 0.5f, body, errorMessage);
             if (!success) {
-                std::cerr << "Failed to create RigidBody2D: " << errorMessage << std::endl;
+                LOG_ERROR("Failed to create RigidBody2D: {}", errorMessage);
             }
 
             engine.AddBody(body);
-            std::cout << engine.GetBodyCount() << endl;
+            LOG_INFO("{} bodies", engine.GetBodyCount());
 
             prevFrameC = true;
         }
@@ -136,19 +114,19 @@ void processInput(GLFWwindow* window, Engine2D& engine) {
 
             worldCoord /= worldCoord.w;
 
-            std::cout << "coordinates are" << worldCoord.x << ", " << worldCoord.y << "\n";
+            LOG_DEBUG("coordinates are {}, {}", worldCoord.x, worldCoord.y);
 
             std::shared_ptr<RigidBody2D> body;
             std::string errorMessage = "";
 
 
-            bool success = RigidBody2D::CreateCircleBody(12.0f, glm::vec2(worldCoord.x, worldCoord.y), 0.5f, false, 0.5f, body, errorMessage, engine.getCircleMesh());
+            bool success = engine.CreateCircleBody(12.0f, glm::vec2(worldCoord.x, worldCoord.y), 0.5f, false, 0.5f, body, errorMessage);
             if (!success) {
-                std::cerr << "Failed to create RigidBody2D: " << errorMessage << std::endl;
+                LOG_ERROR("Failed to create RigidBody2D: {}", errorMessage);
             }
 
             engine.AddBody(body);
-            std::cout << engine.GetBodyCount() << endl;
+            LOG_INFO("{} bodies", engine.GetBodyCount());
             prevFrameS = true;
         }
         
@@ -237,7 +215,7 @@ int main()
     // Initialize GLFW
     if (!glfwInit())
     {
-        std::cout << "Failed to initialize GLFW" << std::endl;
+        LOG_ERROR("Failed to initialize GLFW");
         return -1;
     }
 
@@ -250,7 +228,7 @@ int main()
     GLFWwindow* window = glfwCreateWindow(static_cast<int>(RES_WIDTH), static_cast<int>(RES_HEIGHT), "Physics2D", NULL, NULL);
     if (window == NULL)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return -1;
     }
@@ -261,82 +239,96 @@ int main()
     // Initialize GLAD
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
         glfwTerminate();
         return -1;
     }
 
+#if defined(CHECK_ALLOCATIONS)
+    CheckNarrowPhaseAllocations();
+#endif
+
     // Visable Coordinates in system are x = [-400, 400] and y = [-225, 225] and is in centimeters
 
     // Set OpenGL viewport
     glViewport(0, 0, RES_WIDTH, RES_HEIGHT);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     
-    Engine2D engine = Engine2D();
-
-    int bodyCount = 0;
-
-    std::shared_ptr<RigidBody2D> body;
-    std::string errorMessage = "";
-    bool success = RigidBody2D::CreateSquareBody(RES_WIDTH / SCALE_FACTOR - 20.0f, 10.0f, glm::vec2(0, -(RES_HEIGHT / SCALE_FACTOR / 2.0f) + 20.0f ), 1.0f, true, 0.5f, body, errorMessage, engine.getSquareMesh());
-    if (!success) {
-        std::cerr << "Failed to create RigidBody2D: " << errorMessage << std::endl;
-    }
-    engine.AddBody(body);
-    success = RigidBody2D::CreateSquareBody(RES_WIDTH / (SCALE_FACTOR * 3), 10.0f, glm::vec2((RES_WIDTH / (SCALE_FACTOR * 2)) - 200.0f, 0), 1.0f, true, 0.5f, body, errorMessage, engine.getSquareMesh());
-    if (!success) {
-        std::cerr << "Failed to create RigidBody2D: " << errorMessage << std::endl;
-    }
-    body->Rotate(M_PI/6);
-    engine.AddBody(body);
+    // The engine and its bodies own GL meshes, they have to be gone before the context is
+    {
+        Engine2D engine;
+        engine.ReserveBodies(1024);
 
-    success = RigidBody2D::CreateSquareBody(RES_WIDTH / (SCALE_FACTOR * 3), 10.0f, glm::vec2(-(RES_WIDTH / (SCALE_FACTOR * 2)) + 200.0f, 0), 1.0f, true, 0.5f, body, errorMessage, engine.getSquareMesh());
-    if (!success) {
-        std::cerr << "Failed to create RigidBody2D: " << errorMessage << std::endl;
-    }
-    body->Rotate(-(M_PI / 6));
-    engine.AddBody(body);
+        // Bodies that leave the screen are removed by the engine at the end of the step
+        engine.SetKillBounds(AABB(-RES_WIDTH / (2 * SCALE_FACTOR), -RES_HEIGHT / (2 * SCALE_FACTOR),
+            RES_WIDTH / (2 * SCALE_FACTOR), RES_HEIGHT / (2 * SCALE_FACTOR)));
 
+        int bodyCount = 0;
 
+        std::shared_ptr<RigidBody2D> body;
+        std::string errorMessage = "";
+        bool success = engine.CreateSquareBody(RES_WIDTH / SCALE_FACTOR - 20.0f, 10.0f, glm::vec2(0, -(RES_HEIGHT / SCALE_FACTOR / 2.0f) + 20.0f ), 1.0f, true, 0.5f, body, errorMessage);
+        if (!success) {
+            LOG_ERROR("Failed to create RigidBody2D: {}", errorMessage);
+        }
+        engine.AddBody(body);
+        success = engine.CreateSquareBody(RES_WIDTH / (SCALE_FACTOR * 3), 10.0f, glm::vec2((RES_WIDTH / (SCALE_FACTOR * 2)) - 200.0f, 0), 1.0f, true, 0.5f, body, errorMessage);
+        if (!success) {
+            LOG_ERROR("Failed to create RigidBody2D: {}", errorMessage);
+        }
+        body->Rotate(M_PI/6);
+        engine.AddBody(body);
 
-    // creates shader program
-    Shader ourShader("resources/shaders/col_vertex.vs", "resources/shaders/col_fragment.fs");
-    ourShader.use();
+        success = engine.CreateSquareBody(RES_WIDTH / (SCALE_FACTOR * 3), 10.0f, glm::vec2(-(RES_WIDTH / (SCALE_FACTOR * 2)) + 200.0f, 0), 1.0f, true, 0.5f, body, errorMessage);
+        if (!success) {
+            LOG_ERROR("Failed to create RigidBody2D: {}", errorMessage);
+        }
+        body->Rotate(-(M_PI / 6));
+        engine.AddBody(body);
 
-    glm::mat4 projection = glm::ortho( - RES_WIDTH / (2.0f * SCALE_FACTOR), RES_WIDTH / (2.0f * SCALE_FACTOR),
-        -RES_HEIGHT / (2.0f * SCALE_FACTOR), RES_HEIGHT / (2.0f * SCALE_FACTOR),
-        -1.0f, 1.0f);
 
-    double currentTime = glfwGetTime();
-    double accumulator = 0.0;
-    int ticks = 0;
 
+        // creates shader program
+        Shader ourShader("resources/shaders/col_vertex.vs", "resources/shaders/col_fragment.fs");
+        ourShader.use();
 
-    while (!glfwWindowShouldClose(window)) {
-        double newTime = glfwGetTime();
-        double frameTime = newTime - currentTime;
-        currentTime = newTime;
-        accumulator += frameTime;
+        glm::mat4 projection = glm::ortho( - RES_WIDTH / (2.0f * SCALE_FACTOR), RES_WIDTH / (2.0f * SCALE_FACTOR),
+            -RES_HEIGHT / (2.0f * SCALE_FACTOR), RES_HEIGHT / (2.0f * SCALE_FACTOR),
+            -1.0f, 1.0f);
 
-        while (accumulator >= FIXED_TIMESTEP) {
-            ++ticks;
-            engine.Step(FIXED_TIMESTEP, SUBSTEPS);
-            CullScreen(engine);
-            // Fixed time step logic here (e.g., update physics)
-            accumulator -= FIXED_TIMESTEP;
-        }
-        // Input
-        processInput(window, engine);
+        double currentTime = glfwGetTime();
+        double accumulator = 0.0;
+        int ticks = 0;
+
+
+        while (!glfwWindowShouldClose(window)) {
+            double newTime = glfwGetTime();
+            double frameTime = newTime - currentTime;
+            currentTime = newTime;
+            accumulator += frameTime;
+
+            while (accumulator >= FIXED_TIMESTEP) {
+                ++ticks;
+                engine.Step(FIXED_TIMESTEP, SUBSTEPS);
+                if (!engine.GetKilledBodies().empty()) {
+                    LOG_INFO("removed {} bodies", engine.GetKilledBodies().size());
+                }
+                // Fixed time step logic here (e.g., update physics)
+                accumulator -= FIXED_TIMESTEP;
+            }
+            // Input
+            processInput(window, engine);
         
-        // Rendering Commands 
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+            // Rendering Commands 
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
 
-        engine.Draw(ourShader, projection);
+            engine.Draw(ourShader, projection);
 
-        // Check and call events and swap the buffers
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+            // Check and call events and swap the buffers
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
     // Cleanup and exit
@@ -8,6 +8,12 @@ Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, ShapeType type
     setupMesh();
 }
 
+Mesh::~Mesh() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
 void Mesh::setupMesh() {
     // Generate and bind VAO, VBO, and EBO
     glGenVertexArrays(1, &VAO);
@@ -0,0 +1,158 @@
+#include "../include/pair_cache.h"
+
+const uint64_t PairCache::EMPTY_KEY;
+
+PairCache::PairCache() {
+	keys.assign(64, EMPTY_KEY);
+	values.assign(64, -1);
+	mask = 63;
+}
+
+void PairCache::Reserve(int count) {
+	pairs.reserve(count);
+	while (keys.size() < 2 * count) {
+		Grow();
+	}
+}
+
+uint64_t PairCache::MakeKey(unsigned int idA, unsigned int idB) {
+	if (idA > idB) {
+		unsigned int t = idA;
+		idA = idB;
+		idB = t;
+	}
+	return (static_cast<uint64_t>(idA) << 32) | idB;
+}
+
+unsigned int PairCache::Slot(uint64_t key) const {
+	return static_cast<unsigned int>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+int PairCache::FindSlot(uint64_t key) const {
+	unsigned int slot = Slot(key);
+	while (keys[slot] != EMPTY_KEY) {
+		if (keys[slot] == key) {
+			return slot;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return -1;
+}
+
+int PairCache::Find(unsigned int idA, unsigned int idB) const {
+	int slot = FindSlot(MakeKey(idA, idB));
+	return slot < 0 ? -1 : values[slot];
+}
+
+void PairCache::Grow() {
+	std::vector<uint64_t> oldKeys = keys;
+	std::vector<int> oldValues = values;
+
+	keys.assign(oldKeys.size() * 2, EMPTY_KEY);
+	values.assign(oldKeys.size() * 2, -1);
+	mask = keys.size() - 1;
+
+	for (int i = 0; i < oldKeys.size(); ++i) {
+		if (oldKeys[i] == EMPTY_KEY) {
+			continue;
+		}
+		unsigned int slot = Slot(oldKeys[i]);
+		while (keys[slot] != EMPTY_KEY) {
+			slot = (slot + 1) & mask;
+		}
+		keys[slot] = oldKeys[i];
+		values[slot] = oldValues[i];
+	}
+}
+
+int PairCache::AddPair(unsigned int idA, unsigned int idB) {
+	uint64_t key = MakeKey(idA, idB);
+
+	unsigned int slot = Slot(key);
+	while (keys[slot] != EMPTY_KEY) {
+		if (keys[slot] == key) {
+			Pair& pair = pairs[values[slot]];
+			pair.state = PairState::Persist;
+			pair.seen = true;
+			return values[slot];
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	// Keep the table at most half full
+	if (2 * (pairs.size() + 1) > keys.size()) {
+		Grow();
+		slot = Slot(key);
+		while (keys[slot] != EMPTY_KEY) {
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	Pair pair;
+	pair.idA = key >> 32;
+	pair.idB = key & 0xFFFFFFFFu;
+	pair.state = PairState::Begin;
+	pair.seen = true;
+	pair.touching = false;
+	pair.normal = glm::vec2(0.0f, 0.0f);
+	pair.depth = 0.0f;
+	pair.simplex = SimplexCache();
+	pairs.push_back(pair);
+
+	keys[slot] = key;
+	values[slot] = pairs.size() - 1;
+	return pairs.size() - 1;
+}
+
+void PairCache::RemovePair(int index) {
+	unsigned int slot = FindSlot(MakeKey(pairs[index].idA, pairs[index].idB));
+
+	// Backward shift deletion so lookups never need tombstones
+	unsigned int next = (slot + 1) & mask;
+	while (keys[next] != EMPTY_KEY) {
+		unsigned int home = Slot(keys[next]);
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			keys[slot] = keys[next];
+			values[slot] = values[next];
+			slot = next;
+		}
+		next = (next + 1) & mask;
+	}
+	keys[slot] = EMPTY_KEY;
+	values[slot] = -1;
+
+	// Swap the last pair into the hole
+	int last = pairs.size() - 1;
+	if (index != last) {
+		pairs[index] = pairs[last];
+		values[FindSlot(MakeKey(pairs[index].idA, pairs[index].idB))] = index;
+	}
+	pairs.pop_back();
+}
+
+void PairCache::BeginUpdate() {
+	for (int i = pairs.size() - 1; i >= 0; --i) {
+		if (pairs[i].state == PairState::End) {
+			RemovePair(i);
+		}
+		else {
+			pairs[i].seen = false;
+		}
+	}
+}
+
+void PairCache::EndUpdate() {
+	for (int i = 0; i < pairs.size(); ++i) {
+		if (!pairs[i].seen) {
+			pairs[i].state = PairState::End;
+			pairs[i].touching = false;
+		}
+	}
+}
+
+void PairCache::Clear() {
+	// The table keeps its size so room set aside with Reserve isn't lost
+	pairs.clear();
+	keys.assign(keys.size(), EMPTY_KEY);
+	values.assign(values.size(), -1);
+}
@@ -1,23 +1,53 @@
 #include "../include/rigid_body_2D.h"
 #include "../include/engine_2D.h"
 
+#include <algorithm>
+
+const int RigidBody2D::MAX_POLYGON_VERTICES;
+
 RigidBody2D::RigidBody2D(glm::vec2 position, float density, float mass, float restitution, float area,
-    bool isStatic, float radius, float width, float height, ShapeType shapeType, glm::vec3 color, std::shared_ptr<Mesh> mesh)
+    bool isStatic, float radius, float width, float height, ShapeType shapeType, glm::vec3 color, std::shared_ptr<Mesh> mesh,
+    Span<glm::vec2> polygon)
     : position(position), density(density), mass(mass), restitution(restitution), area(area),
     isStatic(isStatic), radius(radius), width(width), height(height), shapeType(shapeType), color(color), mesh(mesh){
 
+    id = 0;
     linearVelocity = glm::vec2(0.0f, 0.0f);
     angularVelocity = 0.0f;
     angle = 0.0f;
-    inertia = CalculateRotationalInertia();
 
     staticFriction = 0.6f;
     dynamicFriction = 0.4f;
 
     force = glm::vec2(0.0f, 0.0f);
 
-    transformUpdateRequired = true;
-    aabbUpdateRequired = true;
+    dirtyFlags = BodyStore::MOVED;
+    store = nullptr;
+    slot = -1;
+
+    // The square mesh lists its corners in triangle order, the polygon goes counter clockwise
+    polygonVertexCount = 0;
+    if (shapeType == ShapeType::Square) {
+        float halfWidth = 0.5f * width;
+        float halfHeight = 0.5f * height;
+        localVertices[0] = glm::vec2(-halfWidth, -halfHeight);
+        localVertices[1] = glm::vec2(halfWidth, -halfHeight);
+        localVertices[2] = glm::vec2(halfWidth, halfHeight);
+        localVertices[3] = glm::vec2(-halfWidth, halfHeight);
+        polygonVertexCount = 4;
+    }
+    else if (shapeType == ShapeType::ConvexPolygon) {
+        polygonVertexCount = std::min(polygon.size(), (int)MAX_POLYGON_VERTICES);
+        for (int i = 0; i < polygonVertexCount; ++i) {
+            localVertices[i] = polygon[i];
+        }
+    }
+    for (int i = 0; i < polygonVertexCount; ++i) {
+        glm::vec2 edge = localVertices[(i + 1) % polygonVertexCount] - localVertices[i];
+        localNormals[i] = glm::normalize(glm::vec2(edge.y, -edge.x));
+    }
+
+    inertia = CalculateRotationalInertia();
 
     if (isStatic) {
         invMass = 0.0f;
@@ -45,109 +75,251 @@ float RigidBody2D::CalculateRotationalInertia() {
     else if (shapeType == ShapeType::Circle) {
         return ((1.0f / 2.0f) * mass * radius * radius);
     }
+    else if (shapeType == ShapeType::ConvexPolygon) {
+        // Sum over the triangles from the centroid to each edge
+        float twiceArea = 0.0f;
+        float sum = 0.0f;
+        for (int i = 0; i < polygonVertexCount; ++i) {
+            glm::vec2 a = localVertices[i];
+            glm::vec2 b = localVertices[(i + 1) % polygonVertexCount];
+            float cross = a.x * b.y - a.y * b.x;
+            twiceArea += cross;
+            sum += cross * (glm::dot(a, a) + glm::dot(a, b) + glm::dot(b, b));
+        }
+        return mass * sum / (6.0f * twiceArea);
+    }
+    return 0.0f;
 }
 
+void RigidBody2D::CalculatePolygonArea(Span<glm::vec2> vertices, float& area, glm::vec2& centroid) {
+    area = 0.0f;
+    centroid = glm::vec2(0.0f, 0.0f);
+
+    // Relative to the first vertex to keep the cross products small
+    glm::vec2 origin = vertices[0];
+    for (int i = 1; i + 1 < vertices.size(); ++i) {
+        glm::vec2 a = vertices[i] - origin;
+        glm::vec2 b = vertices[i + 1] - origin;
+        float triangleArea = 0.5f * (a.x * b.y - a.y * b.x);
+        area += triangleArea;
+        centroid += triangleArea * (a + b) / 3.0f;
+    }
 
-bool RigidBody2D::CreateCircleBody(float radius, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage, std::shared_ptr<Mesh> mesh) {
-    body = nullptr;
-    errorMessage = "";
+    if (area != 0.0f) {
+        centroid /= area;
+    }
+    centroid += origin;
+}
 
-    float area = M_PI * (radius * radius);
+bool RigidBody2D::IsConvex(Span<glm::vec2> vertices) {
+    // Every other vertex has to be strictly on the inner side of every edge. Only checking
+    // that the turns agree would let self-intersecting stars through, and collinear or
+    // repeated vertices don't count as convex.
+    float sign = 0.0f;
+    for (int i = 0; i < vertices.size(); ++i) {
+        int next = (i + 1) % vertices.size();
+        glm::vec2 a = vertices[i];
+        glm::vec2 edge = vertices[next] - a;
 
+        for (int j = 0; j < vertices.size(); ++j) {
+            if (j == i || j == next) {
+                continue;
+            }
+            glm::vec2 toVertex = vertices[j] - a;
+            float cross = edge.x * toVertex.y - edge.y * toVertex.x;
+
+            if (cross == 0.0f || cross * sign < 0.0f) {
+                return false;
+            }
+            sign = cross;
+        }
+    }
+    return true;
+}
 
 
+template <typename... Args>
+std::shared_ptr<RigidBody2D> RigidBody2D::Allocate(const std::shared_ptr<BodyPool>& pool, Args&&... args) {
+    if (pool != nullptr) {
+        // The body and its reference counts share one block from the pool
+        return std::allocate_shared<RigidBody2D>(PoolAllocator<RigidBody2D>(pool), std::forward<Args>(args)...);
+    }
+    return std::make_shared<RigidBody2D>(std::forward<Args>(args)...);
+}
+
+BodyError RigidBody2D::CheckBody(const BodyDesc& desc) {
+    float area;
+    if (desc.shapeType == ShapeType::Circle) {
+        area = M_PI * (desc.radius * desc.radius);
+    }
+    else if (desc.shapeType == ShapeType::Square) {
+        area = desc.width * desc.height;
+    }
+    else if (desc.shapeType == ShapeType::ConvexPolygon) {
+        if (desc.vertexCount < 3 || desc.vertexCount > MAX_POLYGON_VERTICES) {
+            return BodyError::InvalidShape;
+        }
+        Span<glm::vec2> vertices(desc.vertices, desc.vertexCount);
+        if (!IsConvex(vertices)) {
+            return BodyError::InvalidShape;
+        }
+        glm::vec2 centroid;
+        CalculatePolygonArea(vertices, area, centroid);
+        area = std::abs(area);
+    }
+    else {
+        return BodyError::InvalidShape;
+    }
+
     if (area < Engine2D::MIN_BODY_SIZE) {
-        errorMessage = "CIRCLE RADIUS TOO SMALL";
-        return false;
+        return BodyError::SizeTooSmall;
     }
 
     if (area > Engine2D::MAX_BODY_SIZE) {
-        errorMessage = "CIRCLE RADIUS TOO LARGE";
-        return false;
+        return BodyError::SizeTooLarge;
     }
 
-    if (density < Engine2D::MIN_DENSITY) {
-        errorMessage = "DENSITY IS TOO SMALL";
-        return false;
+    if (desc.density < Engine2D::MIN_DENSITY) {
+        return BodyError::DensityTooSmall;
     }
 
-    if (density > Engine2D::MAX_DENSITY) {
-        errorMessage = "DENSITY IS TOO LARGE";
-        return false;
+    if (desc.density > Engine2D::MAX_DENSITY) {
+        return BodyError::DensityTooLarge;
     }
 
-    restitution = glm::clamp(restitution, 0.0f, 1.0f);
+    return BodyError::None;
+}
+
+std::shared_ptr<RigidBody2D> RigidBody2D::Build(const BodyDesc& desc, std::shared_ptr<Mesh> mesh, const std::shared_ptr<BodyPool>& pool) {
+    float restitution = glm::clamp(desc.restitution, 0.0f, 1.0f);
 
-    float mass = area * density; // mass is in grams, density in g/cm^2
+    if (desc.shapeType == ShapeType::Circle) {
+        float area = M_PI * (desc.radius * desc.radius);
+        float mass = area * desc.density; // mass is in grams, density in g/cm^2
+        return Allocate(pool, desc.position, desc.density, mass, restitution, area, desc.isStatic, desc.radius, 0.0f, 0.0f, ShapeType::Circle, getRandomColor(), mesh);
+    }
 
+    if (desc.shapeType == ShapeType::ConvexPolygon) {
+        float area;
+        glm::vec2 centroid;
+        CalculatePolygonArea(Span<glm::vec2>(desc.vertices, desc.vertexCount), area, centroid);
+
+        // Move the polygon onto its centroid and make it counter clockwise
+        glm::vec2 vertices[MAX_POLYGON_VERTICES];
+        float boundingRadius = 0.0f;
+        for (int i = 0; i < desc.vertexCount; ++i) {
+            int from = area > 0.0f ? i : desc.vertexCount - 1 - i;
+            vertices[i] = desc.vertices[from] - centroid;
+            boundingRadius = std::max(boundingRadius, glm::length(vertices[i]));
+        }
+        area = std::abs(area);
 
-    body = std::make_shared<RigidBody2D>(position, density, mass, restitution, area, isStatic, radius, 0.0f, 0.0f, ShapeType::Circle, getRandomColor(), mesh);
+        float mass = area * desc.density;
+        return Allocate(pool, desc.position + centroid, desc.density, mass, restitution, area, desc.isStatic, boundingRadius, 0.0f, 0.0f,
+            ShapeType::ConvexPolygon, getRandomColor(), mesh, Span<glm::vec2>(vertices, desc.vertexCount));
+    }
 
-    return true;
+    float area = desc.width * desc.height;
+    float mass = area * desc.density; // also * depth
+    return Allocate(pool, desc.position, desc.density, mass, restitution, area, desc.isStatic, 0.0f, desc.width, desc.height, ShapeType::Square, getRandomColor(), mesh);
 }
 
-bool RigidBody2D::CreateSquareBody(float width, float height, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage, std::shared_ptr<Mesh> mesh) {
+BodyError RigidBody2D::CreateBody(const BodyDesc& desc, std::shared_ptr<RigidBody2D>& body, std::shared_ptr<Mesh> mesh, const std::shared_ptr<BodyPool>& pool) {
     body = nullptr;
-    errorMessage = "";
-
-    float area = width * height;
-
-    if (area < Engine2D::MIN_BODY_SIZE) {
-        errorMessage = "AREA TOO SMALL";
-        return false;
-    }
 
-    if (area > Engine2D::MAX_BODY_SIZE) {
-        errorMessage = "AREA TOO LARGE";
-        return false;
+    BodyError error = CheckBody(desc);
+    if (error != BodyError::None) {
+        return error;
     }
 
-    if (density < Engine2D::MIN_DENSITY) {
-        errorMessage = "DENSITY IS TOO SMALL";
-        return false;
-    }
+    body = Build(desc, mesh, pool);
+    return BodyError::None;
+}
 
-    if (density > Engine2D::MAX_DENSITY) {
-        errorMessage = "DENSITY IS TOO LARGE";
-        return false;
+std::string RigidBody2D::getErrorMessage(BodyError error, ShapeType shapeType) {
+    switch (error) {
+    case BodyError::None:
+        return "";
+    case BodyError::SizeTooSmall:
+        return shapeType == ShapeType::Circle ? "CIRCLE RADIUS TOO SMALL" : "AREA TOO SMALL";
+    case BodyError::SizeTooLarge:
+        return shapeType == ShapeType::Circle ? "CIRCLE RADIUS TOO LARGE" : "AREA TOO LARGE";
+    case BodyError::DensityTooSmall:
+        return "DENSITY IS TOO SMALL";
+    case BodyError::DensityTooLarge:
+        return "DENSITY IS TOO LARGE";
+    case BodyError::InvalidShape:
+        return "INVALID SHAPE";
+    case BodyError::CapacityReached:
+        return "ENGINE IS FULL";
     }
+    return "";
+}
 
-    restitution = glm::clamp(restitution, 0.0f, 1.0f);
+bool RigidBody2D::CreateCircleBody(float radius, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage, std::shared_ptr<Mesh> mesh,
+    const std::shared_ptr<BodyPool>& pool) {
+    BodyError error = CreateBody(BodyDesc::Circle(radius, position, density, isStatic, restitution), body, mesh, pool);
+    errorMessage = getErrorMessage(error, ShapeType::Circle);
+    return error == BodyError::None;
+}
 
-    float mass = area * density; // also * depth
+bool RigidBody2D::CreateSquareBody(float width, float height, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage, std::shared_ptr<Mesh> mesh,
+    const std::shared_ptr<BodyPool>& pool) {
+    BodyError error = CreateBody(BodyDesc::Square(width, height, position, density, isStatic, restitution), body, mesh, pool);
+    errorMessage = getErrorMessage(error, ShapeType::Square);
+    return error == BodyError::None;
+}
 
-    body = std::make_shared<RigidBody2D>(position, density, mass, restitution, area, isStatic, 0.0f, width, height, ShapeType::Square, getRandomColor(), mesh);
-    
-    return true;
+bool RigidBody2D::CreatePolygonBody(const glm::vec2* vertices, int vertexCount, glm::vec2 position, float density, bool isStatic, float restitution, std::shared_ptr<RigidBody2D>& body, std::string& errorMessage,
+    const std::shared_ptr<BodyPool>& pool) {
+    BodyError error = CreateBody(BodyDesc::Polygon(vertices, vertexCount, position, density, isStatic, restitution), body, nullptr, pool);
+    errorMessage = getErrorMessage(error, ShapeType::ConvexPolygon);
+    return error == BodyError::None;
 }
 
 void RigidBody2D::Move(glm::vec2 amount) {
-    position += amount;
-    transformUpdateRequired = true;
-    aabbUpdateRequired = true;
+    positionRef() += amount;
+    dirtyFlagsRef() = BodyStore::MOVED;
 }
 
 void RigidBody2D::Rotate(float amount) {
-    angle += amount;
-    transformUpdateRequired = true;
-    aabbUpdateRequired = true;
+    angleRef() += amount;
+    dirtyFlagsRef() = BodyStore::MOVED;
+}
+
+const Transform2D& RigidBody2D::getTransform() {
+    unsigned char& flags = dirtyFlagsRef();
+    if (flags & BodyStore::TRANSFORM_DIRTY) {
+        transform = Transform2D(getPosition(), getAngle());
+        flags &= ~BodyStore::TRANSFORM_DIRTY;
+    }
+    return transform;
 }
 
 glm::mat4 RigidBody2D::getTransformMatrix() {
-    if (transformUpdateRequired) {
-        glm::mat4 trans = glm::mat4(1.0f);
-        trans = glm::translate(trans, glm::vec3(position.x, position.y, 0.0f));
-        trans = glm::rotate(trans, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-        if (shapeType == ShapeType::Square) {
-            trans = glm::scale(trans, glm::vec3(width, height, 1.0f));
-        }
-        else if (shapeType == ShapeType::Circle) {
-            trans = glm::scale(trans, glm::vec3(radius, radius, 1.0f));
-        }
-        transformMatrix = trans;
-        transformUpdateRequired = false;
+    const Transform2D& xf = getTransform();
+
+    glm::vec2 scale = glm::vec2(1.0f, 1.0f);
+    if (shapeType == ShapeType::Square) {
+        scale = glm::vec2(width, height);
+    }
+    else if (shapeType == ShapeType::Circle) {
+        scale = glm::vec2(radius, radius);
+    }
+
+    // Same as translate * rotate * scale, columns are the scaled rotation axes then the position
+    glm::mat4 trans = glm::mat4(1.0f);
+    trans[0] = glm::vec4(xf.cos * scale.x, xf.sin * scale.x, 0.0f, 0.0f);
+    trans[1] = glm::vec4(-xf.sin * scale.y, xf.cos * scale.y, 0.0f, 0.0f);
+    trans[3] = glm::vec4(xf.position.x, xf.position.y, 0.0f, 1.0f);
+    return trans;
+}
+
+float RigidBody2D::getBoundingRadius() const {
+    if (shapeType == ShapeType::Square) {
+        return 0.5f * std::sqrt(width * width + height * height);
     }
-    return transformMatrix;
+    return radius;
 }
 
 vector<glm::vec4> RigidBody2D::getTransformedVertices() {
@@ -159,6 +331,30 @@ vector<glm::vec4> RigidBody2D::getTransformedVertices() {
     return vertices;
 }
 
+void RigidBody2D::UpdateWorldVertices() {
+    unsigned char& flags = dirtyFlagsRef();
+    if (!(flags & BodyStore::VERTICES_DIRTY)) {
+        return;
+    }
+
+    const Transform2D& xf = getTransform();
+    for (int i = 0; i < polygonVertexCount; ++i) {
+        worldVertices[i] = xf.Apply(localVertices[i]);
+        worldNormals[i] = xf.Rotate(localNormals[i]);
+    }
+    flags &= ~BodyStore::VERTICES_DIRTY;
+}
+
+Span<glm::vec2> RigidBody2D::getWorldVertices() {
+    UpdateWorldVertices();
+    return Span<glm::vec2>(worldVertices, polygonVertexCount);
+}
+
+Span<glm::vec2> RigidBody2D::getWorldNormals() {
+    UpdateWorldVertices();
+    return Span<glm::vec2>(worldNormals, polygonVertexCount);
+}
+
 void RigidBody2D::Step(float time, glm::vec2 gravity, int iterations) {
 
     if (isStatic) {
@@ -170,15 +366,15 @@ void RigidBody2D::Step(float time, glm::vec2 gravity, int iterations) {
 
     time /= (float)iterations;
 
-    linearVelocity += gravity * time;
-    position += linearVelocity * time;
+    glm::vec2& velocity = linearVelocityRef();
+    velocity += gravity * time;
+    positionRef() += velocity * time;
 
-    angle += angularVelocity * time;
+    angleRef() += getAngularVelocity() * time;
 
     force = glm::vec2(0.0f, 0.0f);
 
-    transformUpdateRequired = true;
-    aabbUpdateRequired = true;
+    dirtyFlagsRef() = BodyStore::MOVED;
 }
 
 void RigidBody2D::AddForce(glm::vec2 amount) {
@@ -186,17 +382,18 @@ void RigidBody2D::AddForce(glm::vec2 amount) {
 }
 
 AABB RigidBody2D::getAABB() {
-    if (aabbUpdateRequired) {
+    unsigned char& flags = dirtyFlagsRef();
+    if (flags & BodyStore::AABB_DIRTY) {
         float minX = 99999.9f;
         float minY = 99999.9f;
         float maxX = -99999.9f;
         float maxY = -99999.9f;
 
-        if (shapeType == ShapeType::Square) {
-            vector<glm::vec4> vertices = getTransformedVertices();
+        if (polygonVertexCount > 0) {
+            Span<glm::vec2> vertices = getWorldVertices();
 
             for (int i = 0; i < vertices.size(); ++i) {
-                glm::vec4 v = vertices[i];
+                glm::vec2 v = vertices[i];
 
                 if (v.x < minX) { minX = v.x; }
                 if (v.y < minY) { minY = v.y; }
@@ -205,13 +402,14 @@ AABB RigidBody2D::getAABB() {
             }
         }
         else {
-            minX = position.x - radius;
-            minY = position.y - radius;
-            maxX = position.x + radius;
-            maxY = position.y + radius;
+            glm::vec2 center = getPosition();
+            minX = center.x - radius;
+            minY = center.y - radius;
+            maxX = center.x + radius;
+            maxY = center.y + radius;
         }
         this->aabb = AABB(minX, minY, maxX, maxY);
-        aabbUpdateRequired = false;
+        flags &= ~BodyStore::AABB_DIRTY;
     }
     return this->aabb;
 }
\ No newline at end of file
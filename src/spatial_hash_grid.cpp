@@ -0,0 +1,159 @@
+#include "../include/spatial_hash_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+const int SpatialHashGrid::CELLS_PER_BODY;
+
+SpatialHashGrid::SpatialHashGrid(float cellSize) {
+	bounds = nullptr;
+	entryLimit = -1;
+	dropped = 0;
+	SetCellSize(cellSize);
+}
+
+void SpatialHashGrid::AddBody(int index) {
+	bodies.insert(std::lower_bound(bodies.begin(), bodies.end(), index), index);
+}
+
+void SpatialHashGrid::Reserve(int count, bool bounded) {
+	int entryCount = count * CELLS_PER_BODY;
+	int bucketCount = 16;
+	while (bucketCount < 2 * entryCount) {
+		bucketCount *= 2;
+	}
+
+	bodies.reserve(count);
+	unsortedEntries.reserve(entryCount);
+	entries.reserve(entryCount);
+	bucketStart.reserve(bucketCount + 1);
+	bucketFill.reserve(bucketCount);
+	entryLimit = bounded ? entryCount : -1;
+}
+
+void SpatialHashGrid::Remap(const std::vector<int>& oldToNew) {
+	int write = 0;
+	for (int i = 0; i < bodies.size(); ++i) {
+		int body = oldToNew[bodies[i]];
+		if (body >= 0) {
+			bodies[write++] = body;
+		}
+	}
+	bodies.resize(write);
+	std::sort(bodies.begin(), bodies.end());
+}
+
+void SpatialHashGrid::Clear() {
+	bodies.clear();
+	unsortedEntries.clear();
+	entries.clear();
+	bucketStart.clear();
+	bucketFill.clear();
+	bounds = nullptr;
+	dropped = 0;
+}
+
+void SpatialHashGrid::SetCellSize(float size) {
+	cellSize = size;
+	invCellSize = 1.0f / size;
+}
+
+int SpatialHashGrid::CellCoord(float value) const {
+	return static_cast<int>(std::floor(value * invCellSize));
+}
+
+unsigned int SpatialHashGrid::HashCell(int cellX, int cellY) {
+	return static_cast<unsigned int>(cellX) * 73856093u ^ static_cast<unsigned int>(cellY) * 19349663u;
+}
+
+void SpatialHashGrid::Update(const std::vector<AABB>& bounds) {
+	this->bounds = &bounds;
+
+	unsortedEntries.clear();
+	dropped = 0;
+	for (int b = 0; b < bodies.size(); ++b) {
+		int i = bodies[b];
+		const AABB& box = bounds[i];
+		int minX = CellCoord(box.min.x);
+		int minY = CellCoord(box.min.y);
+		int maxX = CellCoord(box.max.x);
+		int maxY = CellCoord(box.max.y);
+
+		for (int y = minY; y <= maxY; ++y) {
+			for (int x = minX; x <= maxX; ++x) {
+				if (entryLimit >= 0 && (int)unsortedEntries.size() >= entryLimit) {
+					++dropped;
+					continue;
+				}
+				unsortedEntries.push_back({ x, y, i });
+			}
+		}
+	}
+
+	// Table size is a power of two at least twice the entry count
+	int bucketCount = 16;
+	while (bucketCount < 2 * unsortedEntries.size()) {
+		bucketCount *= 2;
+	}
+	unsigned int mask = bucketCount - 1;
+
+	// Counting sort of the entries into their buckets
+	bucketStart.assign(bucketCount + 1, 0);
+	for (int i = 0; i < unsortedEntries.size(); ++i) {
+		++bucketStart[(HashCell(unsortedEntries[i].cellX, unsortedEntries[i].cellY) & mask) + 1];
+	}
+	for (int i = 0; i < bucketCount; ++i) {
+		bucketStart[i + 1] += bucketStart[i];
+	}
+
+	entries.resize(unsortedEntries.size());
+	bucketFill.assign(bucketStart.begin(), bucketStart.end() - 1);
+	for (int i = 0; i < unsortedEntries.size(); ++i) {
+		int bucket = HashCell(unsortedEntries[i].cellX, unsortedEntries[i].cellY) & mask;
+		entries[bucketFill[bucket]++] = unsortedEntries[i];
+	}
+}
+
+void SpatialHashGrid::FindPairs(int begin, int end, PairBuffer& pairs) const {
+	if (bounds == nullptr) {
+		return;
+	}
+
+	for (int bucket = begin; bucket < end; ++bucket) {
+		int bucketEnd = bucketStart[bucket + 1];
+
+		for (int i = bucketStart[bucket]; i < bucketEnd; ++i) {
+			const CellEntry& entryA = entries[i];
+			const AABB& boxA = (*bounds)[entryA.body];
+
+			for (int j = i + 1; j < bucketEnd; ++j) {
+				const CellEntry& entryB = entries[j];
+
+				// Different cells can hash to the same bucket
+				if (entryA.cellX != entryB.cellX || entryA.cellY != entryB.cellY) {
+					continue;
+				}
+
+				const AABB& boxB = (*bounds)[entryB.body];
+				if (boxA.max.x <= boxB.min.x || boxB.max.x <= boxA.min.x ||
+					boxA.max.y <= boxB.min.y || boxB.max.y <= boxA.min.y) {
+					continue;
+				}
+
+				// Two bodies can share several cells, only report the pair from the cell
+				// that holds the lower corner of their overlap
+				if (CellCoord(std::max(boxA.min.x, boxB.min.x)) != entryA.cellX ||
+					CellCoord(std::max(boxA.min.y, boxB.min.y)) != entryA.cellY) {
+					continue;
+				}
+
+				if (entryA.body < entryB.body) {
+					pairs.push_back(ContactPair(entryA.body, entryB.body));
+				}
+				else {
+					pairs.push_back(ContactPair(entryB.body, entryA.body));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#include "../include/static_body_tree.h"
+
+#include <algorithm>
+
+void StaticBodyTree::Reserve(int count) {
+	items.reserve(count);
+	// Median splits leave at least two items in every leaf, so there are fewer than
+	// count nodes
+	nodes.reserve(std::max(count, 1));
+}
+
+void StaticBodyTree::Add(int body, const AABB& box) {
+	Item item;
+	item.box = box;
+	item.center = (box.min + box.max) * 0.5f;
+	item.body = body;
+	items.push_back(item);
+}
+
+void StaticBodyTree::Build() {
+	nodes.clear();
+	if (items.empty()) {
+		return;
+	}
+	BuildNode(0, items.size());
+}
+
+void StaticBodyTree::Remap(const std::vector<int>& oldToNew) {
+	// A removed static body marks the tree dirty in the engine, so it's rebuilt before the
+	// next query and only the renames matter here
+	for (int i = 0; i < items.size(); ++i) {
+		items[i].body = oldToNew[items[i].body];
+	}
+}
+
+void StaticBodyTree::Clear() {
+	nodes.clear();
+	items.clear();
+}
+
+int StaticBodyTree::BuildNode(int start, int end) {
+	int nodeId = nodes.size();
+	nodes.push_back(Node());
+
+	AABB box = items[start].box;
+	AABB centerBox = AABB(items[start].center, items[start].center);
+	for (int i = start + 1; i < end; ++i) {
+		box = AABB::Combine(box, items[i].box);
+		centerBox = AABB::Combine(centerBox, AABB(items[i].center, items[i].center));
+	}
+	nodes[nodeId].box = box;
+
+	if (end - start <= MAX_LEAF_SIZE) {
+		nodes[nodeId].start = start;
+		nodes[nodeId].count = end - start;
+		nodes[nodeId].right = -1;
+		return nodeId;
+	}
+
+	// Split at the median along the axis the centers are most spread out on
+	int axis = (centerBox.max.x - centerBox.min.x) >= (centerBox.max.y - centerBox.min.y) ? 0 : 1;
+	int mid = (start + end) / 2;
+	std::nth_element(items.begin() + start, items.begin() + mid, items.begin() + end,
+		[axis](const Item& a, const Item& b) { return a.center[axis] < b.center[axis]; });
+
+	nodes[nodeId].start = 0;
+	nodes[nodeId].count = 0;
+	BuildNode(start, mid);
+	int right = BuildNode(mid, end);
+	nodes[nodeId].right = right;
+	return nodeId;
+}
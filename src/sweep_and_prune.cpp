@@ -0,0 +1,78 @@
+#include "../include/sweep_and_prune.h"
+#include "../include/collisions.h"
+
+#include <algorithm>
+
+void SweepAndPrune::AddBody(int index) {
+	order.push_back(index);
+	sortedBounds.Resize(order.size());
+}
+
+void SweepAndPrune::Reserve(int count) {
+	order.reserve(count);
+	sortedBounds.Reserve(count);
+}
+
+void SweepAndPrune::Remap(const std::vector<int>& oldToNew) {
+	// Renamed bodies keep their place, the order only depends on the bounds
+	int write = 0;
+	for (int i = 0; i < order.size(); ++i) {
+		int body = oldToNew[order[i]];
+		if (body >= 0) {
+			order[write++] = body;
+		}
+	}
+	order.resize(write);
+	sortedBounds.Resize(write);
+}
+
+void SweepAndPrune::Clear() {
+	order.clear();
+	sortedBounds.Clear();
+}
+
+void SweepAndPrune::Update(const std::vector<AABB>& bounds) {
+	for (int i = 0; i < order.size(); ++i) {
+		sortedBounds.Set(i, bounds[order[i]]);
+	}
+
+	// Insertion sort, bodies only swap places with their neighbours from one step to the next
+	for (int i = 1; i < order.size(); ++i) {
+		int body = order[i];
+		AABB box = sortedBounds.Get(i);
+		int j = i - 1;
+		while (j >= 0 && sortedBounds.minX[j] > box.min.x) {
+			order[j + 1] = order[j];
+			sortedBounds.Set(j + 1, sortedBounds.Get(j));
+			--j;
+		}
+		order[j + 1] = body;
+		sortedBounds.Set(j + 1, box);
+	}
+}
+
+void SweepAndPrune::FindPairs(int begin, int end, PairBuffer& pairs) const {
+	int hits[BATCH_SIZE];
+
+	for (int i = begin; i < end; ++i) {
+		int bodyA = order[i];
+		AABB boxA = sortedBounds.Get(i);
+
+		// Everything from here on starts to the right of boxA
+		int last = std::lower_bound(sortedBounds.minX.begin() + i + 1, sortedBounds.minX.end(), boxA.max.x) - sortedBounds.minX.begin();
+
+		for (int j = i + 1; j < last; j += BATCH_SIZE) {
+			int hitCount = Collisions::OverlapAABBBatch(boxA, sortedBounds, j, std::min(j + BATCH_SIZE, last), hits);
+
+			for (int k = 0; k < hitCount; ++k) {
+				int bodyB = order[hits[k]];
+				if (bodyA < bodyB) {
+					pairs.push_back(ContactPair(bodyA, bodyB));
+				}
+				else {
+					pairs.push_back(ContactPair(bodyB, bodyA));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#include "../include/thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool() {
+	task = nullptr;
+	itemCount = 0;
+	rangeCount = 0;
+	nextRange = 0;
+	busyWorkers = 0;
+	generation = 0;
+	stopping = false;
+}
+
+ThreadPool::~ThreadPool() {
+	StopWorkers();
+}
+
+void ThreadPool::StopWorkers() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (int i = 0; i < workers.size(); ++i) {
+		workers[i].join();
+	}
+	workers.clear();
+	stopping = false;
+}
+
+void ThreadPool::SetThreadCount(int count) {
+	StopWorkers();
+	for (int i = 0; i < count; ++i) {
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i + 1, generation));
+	}
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int, int, int)>& task) {
+	// Not worth waking anyone for small loops
+	if (workers.empty() || count < 2 * MIN_RANGE) {
+		if (count > 0) {
+			task(0, 0, count);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->task = &task;
+		itemCount = count;
+		rangeCount = std::min<int>((workers.size() + 1) * RANGES_PER_THREAD, count / MIN_RANGE);
+		nextRange = 0;
+		busyWorkers = workers.size();
+		++generation;
+	}
+	wake.notify_all();
+
+	RunRanges(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]() { return busyWorkers == 0; });
+	this->task = nullptr;
+}
+
+void ThreadPool::RunRanges(int thread) {
+	while (true) {
+		int range = nextRange.fetch_add(1);
+		if (range >= rangeCount) {
+			return;
+		}
+		int begin = static_cast<long long>(itemCount) * range / rangeCount;
+		int end = static_cast<long long>(itemCount) * (range + 1) / rangeCount;
+		(*task)(thread, begin, end);
+	}
+}
+
+void ThreadPool::WorkerLoop(int thread, int lastGeneration) {
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&]() { return stopping || generation != lastGeneration; });
+			if (stopping) {
+				return;
+			}
+			lastGeneration = generation;
+		}
+
+		RunRanges(thread);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busyWorkers == 0) {
+			done.notify_one();
+		}
+	}
+}